@@ -0,0 +1,310 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+#include "console.h"
+#include "movie.h"
+#include "rom.h"
+
+#define FRAME_WIDTH 256
+#define FRAME_HEIGHT 240
+
+// NTSC frame rate 39375000/655171 (about 60.0988 Hz)
+#define FRAME_RATE_NUM 39375000
+#define FRAME_RATE_DEN 655171
+
+// audio stream: signed 16 bit little endian, interleaved stereo
+#define AUDIO_RATE 48000
+#define AUDIO_CHANNELS 2
+
+enum { FORMAT_RGB24, FORMAT_YUV420, FORMAT_Y4M };
+
+static const char *format_names[] = { "rgb24", "yuv420", "y4m" };
+
+// palette -> YUV (BT.601, limited range), filled once at start
+static uint8_t palette_y[64], palette_u[64], palette_v[64];
+
+static uint8_t clamp_byte(double value) {
+  return value<0.0 ? 0 : (value>255.0 ? 255 : (uint8_t)(value+0.5));
+}
+
+static void init_yuv_palette(void) {
+  for (int i=0; i<64; i++) {
+    double r=(ppu_rgb_palette[i]>>16)&0xFF, g=(ppu_rgb_palette[i]>>8)&0xFF, b=ppu_rgb_palette[i]&0xFF;
+
+    palette_y[i]=clamp_byte(16.0+(65.738*r+129.057*g+25.064*b)/256.0);
+    palette_u[i]=clamp_byte(128.0+(-37.945*r-74.494*g+112.439*b)/256.0);
+    palette_v[i]=clamp_byte(128.0+(112.439*r-94.154*g-18.285*b)/256.0);
+  }
+}
+
+// dst[i]=table[src[i]] for a 64 entry table, 16 pixels per step with SSSE3
+static void lookup_row(const uint8_t *table, const uint8_t *src, uint8_t *dst, int count) {
+  int i=0;
+#if defined(__SSSE3__)
+  const __m128i part0=_mm_loadu_si128((const __m128i *)&table[0]);
+  const __m128i part1=_mm_loadu_si128((const __m128i *)&table[16]);
+  const __m128i part2=_mm_loadu_si128((const __m128i *)&table[32]);
+  const __m128i part3=_mm_loadu_si128((const __m128i *)&table[48]);
+  const __m128i low_mask=_mm_set1_epi8(0x0F);
+  const __m128i high_mask=_mm_set1_epi8(0x03);
+
+  for (; i+16<=count; i+=16) {
+    __m128i index=_mm_loadu_si128((const __m128i *)&src[i]);
+    __m128i low=_mm_and_si128(index, low_mask);
+    __m128i high=_mm_and_si128(_mm_srli_epi16(index, 4), high_mask);
+    __m128i result;
+
+    // pshufb looks up 16 entries, the upper two index bits select the part
+    result=_mm_and_si128(_mm_shuffle_epi8(part0, low), _mm_cmpeq_epi8(high, _mm_set1_epi8(0)));
+    result=_mm_or_si128(result, _mm_and_si128(_mm_shuffle_epi8(part1, low), _mm_cmpeq_epi8(high, _mm_set1_epi8(1))));
+    result=_mm_or_si128(result, _mm_and_si128(_mm_shuffle_epi8(part2, low), _mm_cmpeq_epi8(high, _mm_set1_epi8(2))));
+    result=_mm_or_si128(result, _mm_and_si128(_mm_shuffle_epi8(part3, low), _mm_cmpeq_epi8(high, high_mask)));
+    _mm_storeu_si128((__m128i *)&dst[i], result);
+  }
+#endif
+  for (; i<count; i++) {
+    dst[i]=table[src[i]&0x3F];
+  }
+}
+
+// planar 4:2:0, the chroma of a 2x2 block is the mean of its four pixels
+static void convert_yuv420(const uint8_t *frame, uint8_t *out) {
+  uint8_t *plane_y=out;
+  uint8_t *plane_u=out+FRAME_WIDTH*FRAME_HEIGHT;
+  uint8_t *plane_v=plane_u+FRAME_WIDTH*FRAME_HEIGHT/4;
+  uint8_t u[2][FRAME_WIDTH], v[2][FRAME_WIDTH];
+
+  lookup_row(palette_y, frame, plane_y, FRAME_WIDTH*FRAME_HEIGHT);
+  for (int y=0; y<FRAME_HEIGHT; y+=2) {
+    for (int row=0; row<2; row++) {
+      lookup_row(palette_u, &frame[(y+row)*FRAME_WIDTH], u[row], FRAME_WIDTH);
+      lookup_row(palette_v, &frame[(y+row)*FRAME_WIDTH], v[row], FRAME_WIDTH);
+    }
+    for (int x=0; x<FRAME_WIDTH; x+=2) {
+      *plane_u++=(u[0][x]+u[0][x+1]+u[1][x]+u[1][x+1]+2)>>2;
+      *plane_v++=(v[0][x]+v[0][x+1]+v[1][x]+v[1][x+1]+2)>>2;
+    }
+  }
+}
+
+static int write_all(int fd, const void *data, size_t size) {
+  const uint8_t *pointer=data;
+
+  while (size>0) {
+    ssize_t written=write(fd, pointer, size);
+    if (written<=0) {
+      return 0;
+    }
+    pointer+=written;
+    size-=written;
+  }
+  return 1;
+}
+
+// sleep until the frame is due (realtime pacing)
+static void wait_for_frame(const struct timespec *start, uint32_t frame) {
+  struct timespec now, delay;
+  double due=(double)frame*FRAME_RATE_DEN/FRAME_RATE_NUM, elapsed;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  elapsed=(now.tv_sec-start->tv_sec)+(now.tv_nsec-start->tv_nsec)/1e9;
+  if (due>elapsed) {
+    delay.tv_sec=(time_t)(due-elapsed);
+    delay.tv_nsec=(long)((due-elapsed-delay.tv_sec)*1e9);
+    nanosleep(&delay, NULL);
+  }
+}
+
+static void usage(const char *name) {
+  fprintf(stderr, "%s [-b framebuffer|caching] [-f rgb24|yuv420|y4m] [-m movie_file] [-n frames]\n"
+    "  [-o output_file] [-a audio_fd] [-d] [-r] rom_file\n"
+    "  -d: drop frames identical to the previous one, -r: pace at the NTSC frame rate\n", name);
+}
+
+int main(int argc, char* argv[]) {
+  int result, arg=1, format=FORMAT_Y4M, drop_duplicates=0, realtime=0, audio_fd=-1, video_fd=1;
+  uint32_t max_frames=0, frame=0, written_frames=0, console_bytes, frame_bytes;
+  uint64_t audio_phase=0;
+  ppu_backend_t ppu_backend=PPU_BACKEND_FRAMEBUFFER;
+  char *movie_file=NULL, *output_file=NULL;
+  uint8_t controller1=0, controller2=0, *out, *silence;
+  console_t *console;
+  const rom_t *rom;
+  movie_t movie;
+  struct timespec start;
+  FILE *output=NULL;
+
+  while (arg<argc && argv[arg][0]=='-') {
+    if (strcmp(argv[arg], "-d")==0) {
+      drop_duplicates=1;
+    }
+    else if (strcmp(argv[arg], "-r")==0) {
+      realtime=1;
+    }
+    else if (arg+1>=argc) {
+      break;
+    }
+    else if (strcmp(argv[arg], "-b")==0) {
+      if (!ppu_backend_from_name(argv[++arg], &ppu_backend)) {
+        fprintf(stderr, "unknown ppu backend %s\n", argv[arg]);
+        return 1;
+      }
+    }
+    else if (strcmp(argv[arg], "-f")==0) {
+      arg++;
+      format=-1;
+      for (int i=0; i<3; i++) {
+        if (strcmp(argv[arg], format_names[i])==0) {
+          format=i;
+        }
+      }
+      if (format<0) {
+        fprintf(stderr, "unknown format %s\n", argv[arg]);
+        return 1;
+      }
+    }
+    else if (strcmp(argv[arg], "-m")==0) {
+      movie_file=argv[++arg];
+    }
+    else if (strcmp(argv[arg], "-n")==0) {
+      max_frames=strtoul(argv[++arg], NULL, 0);
+    }
+    else if (strcmp(argv[arg], "-o")==0) {
+      output_file=argv[++arg];
+    }
+    else if (strcmp(argv[arg], "-a")==0) {
+      audio_fd=atoi(argv[++arg]);
+    }
+    else {
+      break;
+    }
+    arg++;
+  }
+
+  if (argc-arg<1 || (movie_file==NULL && max_frames==0)) {
+    usage(argv[0]);
+    fprintf(stderr, "(without a movie, the number of frames is needed)\n");
+    return 1;
+  }
+
+  if (rom_open(&rom, argv[arg])!=rom_ok) {
+    fprintf(stderr, "not able to open rom file %s\n", argv[arg]);
+    return 2;
+  }
+
+  if (movie_file!=NULL) {
+    result=movie_play_start(&movie, movie_file, rom->pchData, rom->wSize);
+    if (result) {
+      fprintf(stderr, "unable to play movie file %s (result:%d)\n", movie_file, result);
+      return 4;
+    }
+  }
+
+  console_bytes=console_size(rom->pchData, rom->wSize);
+  if (console_bytes==0 || posix_memalign((void **)&console, JEG_CACHE_LINE_SIZE, console_bytes)) {
+    fprintf(stderr, "unable to parse rom file\n");
+    return 5;
+  }
+  result=console_init(console, console_bytes, ppu_backend, rom->pchData, rom->wSize);
+  if (result) {
+    fprintf(stderr, "unable to parse rom file (result:%d)\n", result);
+    return 5;
+  }
+
+  if (output_file!=NULL) {
+    output=fopen(output_file, "wb");
+    if (output==NULL) {
+      fprintf(stderr, "unable to open output file %s\n", output_file);
+      return 6;
+    }
+    video_fd=fileno(output);
+  }
+  // a closed pipe ends the capture instead of the process
+  signal(SIGPIPE, SIG_IGN);
+
+  init_yuv_palette();
+  frame_bytes=(format==FORMAT_RGB24) ? FRAME_WIDTH*FRAME_HEIGHT*3 : FRAME_WIDTH*FRAME_HEIGHT*3/2;
+  out=malloc(frame_bytes);
+  silence=calloc(AUDIO_RATE/50, AUDIO_CHANNELS*2);
+
+  // rgb24 is written by the ppu directly into the output buffer
+  if (format==FORMAT_RGB24) {
+    ppu_set_pixel_format(&console->tPPU, PPU_PIXEL_RGB888, out);
+  }
+
+  if (format==FORMAT_Y4M) {
+    // C420jpeg: chroma sited between the four pixels, A8:7: NES pixel aspect ratio
+    char header[128];
+    int size=snprintf(header, sizeof(header), "YUV4MPEG2 W%d H%d F%d:%d Ip A8:7 C420jpeg\n",
+      FRAME_WIDTH, FRAME_HEIGHT, FRAME_RATE_NUM, FRAME_RATE_DEN);
+    if (!write_all(video_fd, header, size)) {
+      fprintf(stderr, "unable to write the stream\n");
+      return 7;
+    }
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  while (max_frames==0 || frame<max_frames) {
+    if (movie_file!=NULL && !movie_play_frame(&movie, &controller1, &controller2)) {
+      break;
+    }
+    controller_direct_set(&console->tNES, controller1, controller2);
+    nes_iterate_frame(&console->tNES);
+    frame++;
+
+    // audio: there is no APU yet, silence keeps the stream in sync with the video
+    if (audio_fd>=0) {
+      uint32_t samples;
+      audio_phase+=(uint64_t)AUDIO_RATE*FRAME_RATE_DEN;
+      samples=audio_phase/FRAME_RATE_NUM;
+      audio_phase%=FRAME_RATE_NUM;
+      if (!write_all(audio_fd, silence, samples*AUDIO_CHANNELS*2)) {
+        fprintf(stderr, "unable to write the audio stream\n");
+        break;
+      }
+    }
+
+    // the ppu tracks changed lines, the first frame is always written (all lines are dirty after reset)
+    if (drop_duplicates) {
+      if (!ppu_frame_changed(&console->tPPU)) {
+        continue;
+      }
+      ppu_clear_dirty_lines(&console->tPPU);
+    }
+
+    if (format!=FORMAT_RGB24) {
+      convert_yuv420(console->chFrame, out);
+    }
+    if (realtime) {
+      wait_for_frame(&start, frame);
+    }
+    if ((format==FORMAT_Y4M && !write_all(video_fd, "FRAME\n", 6)) || !write_all(video_fd, out, frame_bytes)) {
+      fprintf(stderr, "unable to write the stream\n");
+      break;
+    }
+    written_frames++;
+  }
+
+  fprintf(stderr, "%u frames emulated, %u written (%s %dx%d)\n", frame, written_frames, format_names[format],
+    FRAME_WIDTH, FRAME_HEIGHT);
+
+  if (movie_file!=NULL) {
+    movie_close(&movie);
+  }
+  if (output!=NULL) {
+    fclose(output);
+  }
+  free(silence);
+  free(out);
+  free(console);
+  rom_close(rom);
+  rom_cache_clear();
+
+  return 0;
+}
@@ -0,0 +1,154 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include "console.h"
+#include "movie.h"
+#include "hash.h"
+#include "rom.h"
+#include "export.h"
+#include "nes.h"
+
+// hash everything which is visible from outside: cpu registers, ram, cartridge ram and the picture
+static uint64_t state_hash(nes_t *nes, cartridge_t *cartridge, uint8_t *video_frame_data) {
+  uint8_t registers[9];
+  uint64_t hash=HASH_FNV1A64_INIT;
+
+  registers[0]=nes->cpu.reg_A;
+  registers[1]=nes->cpu.reg_X;
+  registers[2]=nes->cpu.reg_Y;
+  registers[3]=nes->cpu.reg_SP;
+  registers[4]=nes->cpu.reg_PC&0xFF;
+  registers[5]=nes->cpu.reg_PC>>8;
+  registers[6]=nes->cpu.chStatus;
+  registers[7]=nes->cpu.cycle_number&0xFF;
+  registers[8]=(nes->cpu.cycle_number>>8)&0xFF;
+
+  hash=hash_fnv1a64(hash, registers, sizeof(registers));
+  hash=hash_fnv1a64(hash, nes->ram_data, sizeof(nes->ram_data));
+  hash=hash_fnv1a64(hash, cartridge->pchPRGRAM, cartridge->wPRGRAMSize);
+  hash=hash_fnv1a64(hash, video_frame_data, 256*240);
+  return hash;
+}
+
+int main(int argc, char* argv[]) {
+  int result, quiet=0, arg=1, clone_frames=0;
+  char *export_name=NULL;
+  export_t export;
+  ppu_backend_t ppu_backend=PPU_BACKEND_FRAMEBUFFER;
+  console_t *console, *clone;
+  uint32_t console_bytes;
+  movie_t movie;
+  const rom_t *rom;
+  uint8_t controller1, controller2;
+  uint64_t hash=HASH_FNV1A64_INIT, total_hash=HASH_FNV1A64_INIT;
+  clock_t start;
+  double seconds;
+
+  while (arg<argc && argv[arg][0]=='-') {
+    if (strcmp(argv[arg], "-q")==0) {
+      quiet=1;
+    }
+    else if (strcmp(argv[arg], "-e")==0 && arg+1<argc) {
+      export_name=argv[++arg];
+    }
+    else if (strcmp(argv[arg], "-c")==0 && arg+1<argc) {
+      clone_frames=atoi(argv[++arg]);
+    }
+    else if (strcmp(argv[arg], "-b")==0 && arg+1<argc) {
+      if (!ppu_backend_from_name(argv[++arg], &ppu_backend)) {
+        printf("unknown ppu backend %s\n", argv[arg]);
+        return 1;
+      }
+    }
+    else {
+      break;
+    }
+    arg++;
+  }
+
+  if (argc-arg<2) {
+    printf("%s [-q] [-b framebuffer|caching] [-c frames] [-e shm_name] rom_file movie_file\n", argv[0]);
+    return 1;
+  }
+
+  // load rom file
+  if (rom_open(&rom, argv[arg])!=rom_ok) {
+    printf("not able to open rom file %s\n", argv[arg]);
+    return 2;
+  }
+
+  result=movie_play_start(&movie, argv[arg+1], rom->pchData, rom->wSize);
+  if (result) {
+    printf("unable to play movie file %s (result:%d)\n", argv[arg+1], result);
+    return 4;
+  }
+
+  if (movie.tHeader.wEmulatorVersion!=JEG_VERSION) {
+    fprintf(stderr, "note: movie recorded with version %06" PRIxFAST32 ", this is %06x\n",
+      movie.tHeader.wEmulatorVersion, JEG_VERSION);
+  }
+
+  // init nes, all of its state is in one block
+  console_bytes=console_size(rom->pchData, rom->wSize);
+  if (console_bytes==0 || posix_memalign((void **)&console, JEG_CACHE_LINE_SIZE, console_bytes)) {
+    printf("unable to parse rom file\n");
+    return 5;
+  }
+  result=console_init(console, console_bytes, ppu_backend, rom->pchData, rom->wSize);
+  if (result) {
+    printf("unable to parse rom file (result:%d)\n", result);
+    return 5;
+  }
+
+  // frames and RAM are exported to slot 0 of a shared memory segment (see export.h)
+  if (export_name!=NULL && export_create(&export, export_name, 1)!=export_ok) {
+    printf("unable to create shared memory %s\n", export_name);
+    return 7;
+  }
+
+  // replay as fast as possible
+  start=clock();
+  while (movie_play_frame(&movie, &controller1, &controller2)) {
+    controller_direct_set(&console->tNES, controller1, controller2);
+    nes_iterate_frame(&console->tNES);
+
+    if (export_name!=NULL) {
+      export_publish(&export, 0, console->chFrame, console->tNES.ram_data);
+    }
+
+    hash=state_hash(&console->tNES, &console->tCartridge, console->chFrame);
+    total_hash=hash_fnv1a64(total_hash, &hash, sizeof(hash));
+    if (!quiet) {
+      printf("%" PRIuFAST32 " %016" PRIx64 "\n", movie.wFrame, hash);
+    }
+
+    // continue with a clone every clone_frames frames, the hashes have to stay the same
+    if (clone_frames>0 && movie.wFrame%clone_frames==0) {
+      if (posix_memalign((void **)&clone, JEG_CACHE_LINE_SIZE, console_bytes) ||
+          console_clone(clone, console_bytes, console)) {
+        printf("unable to clone the console\n");
+        return 6;
+      }
+      memset(console, 0xA5, console_bytes);
+      free(console);
+      console=clone;
+    }
+  }
+  seconds=(double)(clock()-start)/CLOCKS_PER_SEC;
+
+  printf("total %" PRIuFAST32 " %016" PRIx64 "\n", movie.wFrame, total_hash);
+  fprintf(stderr, "%" PRIuFAST32 " frames in %.3f s (%.1f fps)\n", movie.wFrame, seconds,
+    seconds>0?movie.wFrame/seconds:0.0);
+
+  movie_close(&movie);
+  if (export_name!=NULL) {
+    export_close(&export);
+  }
+  free(console);
+  rom_close(rom);
+  rom_cache_clear();
+
+  return 0;
+}
@@ -1,33 +1,42 @@
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 #include <SDL.h>
-#include "ppu_framebuffer.h"
+#include "ppu.h"
 #include "controller_direct.h"
 #include "cartridge.h"
+#include "movie.h"
+#include "rom.h"
+#include "save.h"
 #include "nes.h"
 
 // global variables
 SDL_Window *window;
 SDL_Renderer *renderer;
 SDL_Texture *texture;
-uint32_t pixels[256*240];
-
-static const uint32_t rgb_palette[64] = {
-  0x7C7C7C, 0x0000FC, 0x0000BC, 0x4428BC, 0x940084, 0xA80020, 0xA81000, 0x881400,
-  0x503000, 0x007800, 0x006800, 0x005800, 0x004058, 0x000000, 0x000000, 0x000000,
-  0xBCBCBC, 0x0078F8, 0x0058F8, 0x6844FC, 0xD800CC, 0xE40058, 0xF83800, 0xE45C10,
-  0xAC7C00, 0x00B800, 0x00A800, 0x00A844, 0x008888, 0x000000, 0x000000, 0x000000,
-  0xF8F8F8, 0x3CBCFC, 0x6888FC, 0x9878F8, 0xF878F8, 0xF85898, 0xF87858, 0xFCA044,
-  0xF8B800, 0xB8F818, 0x58D854, 0x58F898, 0x00E8D8, 0x787878, 0x000000, 0x000000,
-  0xFCFCFC, 0xA4E4FC, 0xB8B8F8, 0xD8B8F8, 0xF8B8F8, 0xF8A4C0, 0xF0D0B0, 0xFCE0A8,
-  0xF8D878, 0xD8F878, 0xB8F8B8, 0xB8F8D8, 0x00FCFC, 0xF8D8F8, 0x000000, 0x000000
-};
-
-void update_frame(uint8_t* frame_data) {
-  for (uint32_t i=0; i<256*240; i++) {
-    pixels[i]=rgb_palette[frame_data[i]];
+uint32_t pixels[256*240]; // written by the ppu (ARGB8888)
+
+// only the lines changed by the ppu are uploaded
+void update_frame(const uint32_t *dirty_lines) {
+  int first=-1, last=-1;
+  SDL_Rect rect;
+
+  for (int y=0; y<240; y++) {
+    if (dirty_lines!=NULL && !ppu_line_dirty(dirty_lines, y)) {
+      continue;
+    }
+    if (first<0) {
+      first=y;
+    }
+    last=y;
+  }
+  if (first>=0) {
+    rect.x=0;
+    rect.y=first;
+    rect.w=256;
+    rect.h=last-first+1;
+    SDL_UpdateTexture(texture, &rect, &pixels[first*256], 256*sizeof(uint32_t));
   }
-  SDL_UpdateTexture(texture, NULL, pixels, 256*sizeof(uint32_t));
   SDL_RenderClear(renderer);
   SDL_RenderCopy(renderer, texture, NULL, NULL);
   SDL_RenderPresent(renderer);
@@ -40,36 +49,60 @@ int main(int argc, char* argv[]) {
   ppu_t ppu;
   controller_direct_t controller;
   SDL_Event event;
-  FILE *rom_file;
-  uint8_t *rom_data;
-  uint32_t rom_size;
-  uint8_t video_frame_data[256*240];
+  const rom_t *rom;
+  uint8_t *cartridge_ram;
+  uint32_t cartridge_ram_bytes;
+  save_t save;
+  int use_save=0;
+  char save_file[1024];
+  char *extension;
+  uint32_t frame=0;
   uint8_t controller1=0;
+  uint8_t movie_controller1, movie_controller2;
+  movie_t movie;
+  int movie_mode=0; // 0: no movie, 'r': record, 'p': play
+  char *movie_file=NULL;
+  ppu_backend_t ppu_backend=PPU_BACKEND_FRAMEBUFFER;
   int wait_ms;
   double next_frame_tick=SDL_GetTicks()+1000.0/60.0;
 
   // load rom file
   if (argc<2) {
-    printf("need rom file as argument\n");
+    printf("%s rom_file [-r movie_file | -p movie_file] [-b framebuffer|caching]\n", argv[0]);
     return 1;
   }
 
-  rom_file=fopen(argv[1], "rb");
+  for (int arg=2; arg+1<argc; arg+=2) {
+    if (strcmp(argv[arg], "-r")==0 || strcmp(argv[arg], "-p")==0) {
+      movie_mode=argv[arg][1];
+      movie_file=argv[arg+1];
+    }
+    else if (strcmp(argv[arg], "-b")==0) {
+      if (!ppu_backend_from_name(argv[arg+1], &ppu_backend)) {
+        printf("unknown ppu backend %s\n", argv[arg+1]);
+        return 1;
+      }
+    }
+  }
 
-  if (rom_file==NULL) {
+  if (rom_open(&rom, argv[1])!=rom_ok) {
     printf("not able to open rom file %s\n", argv[1]);
     return 2;
   }
 
-  fseek(rom_file, 0, SEEK_END);
-  rom_size=ftell(rom_file);
-  fseek(rom_file, 0, SEEK_SET);
-  rom_data=malloc(rom_size);
-  if (fread(rom_data, 1, rom_size, rom_file)!=rom_size) {
-    printf("unable to read data from rom file %s\n", argv[1]);
-    return 3;
+  if (movie_mode=='r') {
+    result=movie_record_start(&movie, movie_file, rom->pchData, rom->wSize);
+  }
+  else if (movie_mode=='p') {
+    result=movie_play_start(&movie, movie_file, rom->pchData, rom->wSize);
+  }
+  else {
+    result=0;
+  }
+  if (result) {
+    printf("unable to open movie file %s (result:%d)\n", movie_file, result);
+    return 7;
   }
-  fclose(rom_file);
 
   // init SDL
   if (SDL_Init(SDL_INIT_VIDEO) < 0 ) {
@@ -85,15 +118,35 @@ int main(int argc, char* argv[]) {
   texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, 256, 240);
 
   // init nes
-  ppu_init(&nes_console, &ppu, video_frame_data);
+  ppu_init(&nes_console, &ppu, ppu_backend, (uint8_t *)pixels);
+  ppu_set_pixel_format(&ppu, PPU_PIXEL_ARGB8888, pixels);
   controller_direct_init(&nes_console, &controller);
-  result = cartridge_init(&nes_console, &cartridge, rom_data, rom_size);
+  cartridge_ram_bytes = cartridge_ram_size(rom->pchData, rom->wSize);
+  cartridge_ram = malloc(cartridge_ram_bytes);
+  result = cartridge_init(&nes_console, &cartridge, rom->pchData, rom->wSize, cartridge_ram, cartridge_ram_bytes);
   nes_init(&nes_console);
   if (result) {
     printf("unable to parse rom file (result:%d)\n", result);
     return 6;
   }
 
+  // battery backed RAM is kept in rom_file.sav (not while a movie is used, it has to start from power up)
+  if (!movie_mode && cartridge_battery_ram_size(&cartridge)) {
+    snprintf(save_file, sizeof(save_file), "%s", argv[1]);
+    extension=strrchr(save_file, '.');
+    if (extension==NULL || strchr(extension, '/')!=NULL) {
+      extension=save_file+strlen(save_file);
+    }
+    snprintf(extension, sizeof(save_file)-(extension-save_file), ".sav");
+    if (save_open(&save, save_file, cartridge_battery_ram_size(&cartridge))==save_ok) {
+      cartridge_attach_battery_ram(&cartridge, save.pchData, save.wSize);
+      use_save=1;
+    }
+    else {
+      printf("unable to open save file %s, the game is not saved\n", save_file);
+    }
+  }
+
   int quit = 0;
   uint16_t key_value;
 
@@ -141,7 +194,15 @@ int main(int argc, char* argv[]) {
               quit=1;
               break;
             case SDLK_r: 
-              nes_reset(&nes_console);
+              if (movie_mode) {
+                printf("reset is not possible while recording or playing a movie\n");
+              }
+              else {
+                nes_reset(&nes_console);
+                if (use_save) {
+                  save_sync(&save);
+                }
+              }
               break;
             default:
               break;
@@ -155,9 +216,30 @@ int main(int argc, char* argv[]) {
       default:
         break;
     }
-    controller_direct_set(&nes_console, controller1, 0);
+    if (movie_mode=='p') {
+      if (movie_play_frame(&movie, &movie_controller1, &movie_controller2)) {
+        controller_direct_set(&nes_console, movie_controller1, movie_controller2);
+      }
+      else {
+        printf("movie finished after %u frames\n", (unsigned int)movie.wFrame);
+        movie_close(&movie);
+        movie_mode=0;
+        controller_direct_set(&nes_console, controller1, 0);
+      }
+    }
+    else {
+      if (movie_mode=='r') {
+        movie_record_frame(&movie, controller1, 0);
+      }
+      controller_direct_set(&nes_console, controller1, 0);
+    }
     nes_iterate_frame(&nes_console);
-    update_frame(video_frame_data);
+    update_frame(ppu_dirty_lines(&ppu));
+    ppu_clear_dirty_lines(&ppu);
+    frame++;
+    if (use_save && frame%60==0) {
+      save_check(&save);
+    }
     wait_ms= (int)next_frame_tick-SDL_GetTicks();
     if (wait_ms<0) {
       wait_ms=0;
@@ -166,7 +248,15 @@ int main(int argc, char* argv[]) {
     next_frame_tick+=1000.0/60.0;
   }
 
-  free(rom_data);
+  if (movie_mode) {
+    movie_close(&movie);
+  }
+  if (use_save) {
+    save_close(&save);
+  }
+  free(cartridge_ram);
+  rom_close(rom);
+  rom_cache_clear();
   SDL_Quit();
   
   return 0;
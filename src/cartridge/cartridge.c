@@ -1,13 +1,48 @@
 #include <string.h>
 #include "cartridge.h"
+#include "hash.h"
 #include "jeg_cfg.h"
 #include "nes.h"
 
-cartridge_err_t cartridge_load(cartridge_t *ptCartridge, uint8_t *pchData, uint_fast32_t wSize) {
-    iNES_t *ptHeader = (iNES_t *)pchData;
-    uint_fast32_t wPRGSize, wCHRSize;
-    
-    if (NULL == ptCartridge || NULL == pchData) {
+//! \brief 0x6000-0x7FFF of boards without PRG-RAM (shared, never written)
+static const uint8_t cartridge_no_prg_ram[0x2000];
+
+//! \brief NES 2.0 ROM size: a number of units or, if the upper nibble is 0xF, exponent and multiplier
+static uint_fast32_t nes20_rom_size(uint_fast8_t chLow, uint_fast8_t chHigh, uint_fast32_t wUnit)
+{
+    if (0x0F == chHigh) {
+        if ((chLow >> 2) > 24) {
+            return 0;                                                           //!< not supported (>= 16MByte)
+        }
+        return ((uint_fast32_t)1 << (chLow >> 2)) * ((chLow & 0x03) * 2 + 1);
+    }
+    return ((chHigh << 8) | chLow) * wUnit;
+}
+
+//! \brief NES 2.0 RAM size: 64 << n bytes, 0 for none
+static uint_fast32_t nes20_ram_size(uint_fast8_t chShift)
+{
+    return chShift ? (uint_fast32_t)64 << chShift : 0;
+}
+
+#if JEG_USE_ROM_DATABASE == ENABLED
+static const cartridge_db_entry_t *cartridge_db_find(const uint8_t *pchROM, uint_fast32_t wSize)
+{
+    uint32_t wCRC32 = hash_crc32(HASH_CRC32_INIT, pchROM, wSize);
+
+    for (uint_fast32_t n = 0; n < cartridge_db_size; n++) {
+        if (cartridge_db[n].wCRC32 == wCRC32) {
+            return &cartridge_db[n];
+        }
+    }
+    return NULL;
+}
+#endif
+
+cartridge_err_t cartridge_parse(const uint8_t *pchData, uint_fast32_t wSize, cartridge_info_t *ptInfo) {
+    const iNES_t *ptHeader = (const iNES_t *)pchData;
+
+    if (NULL == pchData || NULL == ptInfo) {
         return err_illegal_pointer;
     }
 
@@ -20,98 +55,215 @@ cartridge_err_t cartridge_load(cartridge_t *ptCartridge, uint8_t *pchData, uint_
         return err_invalid_rom;
     }
 
-    wPRGSize = 0x4000 * ptHeader->chPRGROMBankCount;
-    wCHRSize = 0x2000 * ptHeader->chCHRROMBankCount;
-
-    ptCartridge->chMirror =     ptHeader->VerticalMirroring 
-                            +  (ptHeader->FourScreenMirroring << 1);
-
-    if (strncmp("DiskDude!", (const char *)ptHeader->chDiskDudeString, 9)) {
-        //! if "DiskDude!" string is present, ignore upper 4 bits for mapper
-        ptCartridge->chMapper = ptHeader->MapperLow;
+    memset(ptInfo, 0, sizeof(cartridge_info_t));
+    ptInfo->bBattery = ptHeader->BatteryBackedRAM;
+    ptInfo->bTrainer = ptHeader->Trainer;
+    if (ptHeader->FourScreenMirroring) {
+        ptInfo->chMirror = CARTRIDGE_MIRROR_FOUR_SCREEN;
     } else {
-        ptCartridge->chMapper = ptHeader->MapperLow | (ptHeader->MapperHigh << 4);
+        ptInfo->chMirror = ptHeader->VerticalMirroring  ? CARTRIDGE_MIRROR_VERTICAL
+                                                        : CARTRIDGE_MIRROR_HORIZONTAL;
     }
 
+    if (INES_FORMAT_NES20 == ptHeader->HeaderFormat) {
+        ptInfo->bNES20          = true;
+        ptInfo->hwMapper        =   ptHeader->MapperLow 
+                                |   (ptHeader->MapperHigh << 4) 
+                                |   (ptHeader->MapperHighest << 8);
+        ptInfo->chSubmapper     = ptHeader->Submapper;
+        ptInfo->wPRGROMSize     = nes20_rom_size(ptHeader->chPRGROMBankCount, ptHeader->chROMSizeHigh & 0x0F, 0x4000);
+        ptInfo->wCHRROMSize     = nes20_rom_size(ptHeader->chCHRROMBankCount, ptHeader->chROMSizeHigh >> 4, 0x2000);
+        ptInfo->wPRGRAMSize     =   nes20_ram_size(ptHeader->chPRGRAMShift & 0x0F)
+                                +   nes20_ram_size(ptHeader->chPRGRAMShift >> 4);
+        ptInfo->wCHRRAMSize     =   nes20_ram_size(ptHeader->chCHRRAMShift & 0x0F)
+                                +   nes20_ram_size(ptHeader->chCHRRAMShift >> 4);
+    } else {
+        ptInfo->wPRGROMSize     = 0x4000 * ptHeader->chPRGROMBankCount;
+        ptInfo->wCHRROMSize     = 0x2000 * ptHeader->chCHRROMBankCount;
+        ptInfo->wCHRRAMSize     = ptInfo->wCHRROMSize ? 0 : 0x2000;
 
-    if (ptCartridge->chMapper !=0 && ptCartridge->chMapper !=3 ) { // ines #3 is just a quick fix for a test rom
-        return err_unsupported_mapper;
+        //! bytes 12-15 are unused by iNES, text of a dumper there ("DiskDude!") overwrote bytes 7-11 too
+        if (0 == (pchData[12] | pchData[13] | pchData[14] | pchData[15])) {
+            ptInfo->hwMapper    = ptHeader->MapperLow | (ptHeader->MapperHigh << 4);
+            ptInfo->wPRGRAMSize = 0x2000 * (ptHeader->ch8KRAMBankCount ? ptHeader->ch8KRAMBankCount : 1);
+        } else {
+            //! ignore upper 4 bits for mapper and the RAM size
+            ptInfo->wPRGRAMSize = 0x2000;
+        }
+    }
+
+    //! the mappers switch PRG-ROM in 8KByte and CHR in 1KByte banks, NES 2.0 headers may describe less
+    if (ptInfo->wPRGROMSize < 0x2000) {
+        return err_invalid_rom;
+    }
+    if (ptInfo->wCHRROMSize ? (ptInfo->wCHRROMSize < 0x400) : (0 == ptInfo->wCHRRAMSize)) {
+        return err_invalid_rom;                                                 //!< no CHR at all
     }
 
-    if (wSize < (    wPRGSize 
-                +    wCHRSize 
+    if (wSize < (    ptInfo->wPRGROMSize 
+                +    ptInfo->wCHRROMSize 
                 +    sizeof(iNES_t)                                             //!< should be 16 bytes
-                +    (ptHeader->Trainer ? 512 : 0 ))) {
+                +    (ptInfo->bTrainer ? 512 : 0 ))) {
         return err_imcomplete_rom;
     }
 
-    memset(ptCartridge->chIOData, 0, 0x2000);
+#if JEG_USE_ROM_DATABASE == ENABLED
+    //! a NES 2.0 header is trusted, an iNES header might be wrong
+    if (!ptInfo->bNES20) {
+        const cartridge_db_entry_t *ptEntry = cartridge_db_find(
+                pchData + sizeof(iNES_t) + (ptInfo->bTrainer ? 512 : 0),
+                ptInfo->wPRGROMSize + ptInfo->wCHRROMSize);
+
+        if (NULL != ptEntry) {
+            ptInfo->hwMapper    = ptEntry->hwMapper;
+            ptInfo->chMirror    = ptEntry->chMirror;
+            ptInfo->bBattery    = ptEntry->bBattery;
+            ptInfo->wPRGRAMSize = ptEntry->wPRGRAMSize;
+        }
+    }
+#endif
+
+    return ok;
+}
+
+//! \brief RAM sizes as allocated: bank pointers need whole 8KByte banks
+static uint_fast32_t prg_ram_size(const cartridge_info_t *ptInfo)
+{
+    return (ptInfo->wPRGRAMSize + 0x1FFF) & ~(uint_fast32_t)0x1FFF;
+}
+
+static uint_fast32_t chr_ram_size(const cartridge_info_t *ptInfo)
+{
+    //! CHR-RAM is only used without CHR-ROM
+    return ptInfo->wCHRROMSize ? 0 : (ptInfo->wCHRRAMSize + 0x1FFF) & ~(uint_fast32_t)0x1FFF;
+}
+
+static uint_fast32_t name_table_ram_size(const cartridge_info_t *ptInfo)
+{
+    return (CARTRIDGE_MIRROR_FOUR_SCREEN == ptInfo->chMirror) ? 0x1000 : 0x800;
+}
+
+uint_fast32_t cartridge_ram_size(const uint8_t *pchData, uint_fast32_t wSize) {
+    cartridge_info_t tInfo;
+
+    if (ok != cartridge_parse(pchData, wSize, &tInfo)) {
+        return 0;
+    }
+    return prg_ram_size(&tInfo) + chr_ram_size(&tInfo) + name_table_ram_size(&tInfo);
+}
+
+cartridge_err_t cartridge_load(cartridge_t *ptCartridge, const uint8_t *pchData, uint_fast32_t wSize,
+                               uint8_t *pchRAM, uint_fast32_t wRAMSize) {
+    cartridge_info_t *ptInfo = &ptCartridge->tInfo;
+    cartridge_err_t tResult;
+
+    ptCartridge->ptMapper = NULL;
+
+    tResult = cartridge_parse(pchData, wSize, ptInfo);
+    if (ok != tResult) {
+        return tResult;
+    }
+
+    ptCartridge->ptMapper = mapper_find(ptInfo->hwMapper);
+    if (NULL == ptCartridge->ptMapper) {
+        return err_unsupported_mapper;
+    }
+
+    if (NULL == pchRAM) {
+        ptCartridge->ptMapper = NULL;
+        return err_illegal_pointer;
+    }
+    if (wRAMSize < prg_ram_size(ptInfo) + chr_ram_size(ptInfo) + name_table_ram_size(ptInfo)) {
+        ptCartridge->ptMapper = NULL;
+        return err_illegal_size;
+    }
+
+    //! RAM block: PRG-RAM, CHR-RAM, name tables
+    memset(pchRAM, 0, wRAMSize);
+    ptCartridge->wPRGRAMSize = prg_ram_size(ptInfo);
+    ptCartridge->pchPRGRAM = ptCartridge->wPRGRAMSize ? pchRAM : NULL;
+    ptCartridge->pchNameTableRAM = pchRAM + ptCartridge->wPRGRAMSize + chr_ram_size(ptInfo);
+    ptCartridge->chNameTableCount = name_table_ram_size(ptInfo) >> 10;
 
     //! skip header and trainer data
-    ptCartridge->pchPRGMemory =   pchData 
+    //! the image may be a read-only mapping, ROM banks are never written
+    ptCartridge->pchPRGMemory =   (uint8_t *)pchData 
                             +   sizeof(iNES_t)                                  //!< should be 16 bytes
-                            +   (ptHeader->Trainer ? 512 : 0 ); 
-    
-    if (wCHRSize) {
-        ptCartridge->pchCHRMemory = ptCartridge->pchPRGMemory + wPRGSize;
-        
-    } else {
-        ptCartridge->pchCHRMemory = ptCartridge->chCHRData;
-        wCHRSize = 0x2000;
+                            +   (ptInfo->bTrainer ? 512 : 0 ); 
+    ptCartridge->wPRGSize = ptInfo->wPRGROMSize;
 
-        memset(ptCartridge->pchCHRMemory, 0, 0x2000);
+    if (ptInfo->wCHRROMSize) {
+        ptCartridge->pchCHRMemory = ptCartridge->pchPRGMemory + ptInfo->wPRGROMSize;
+        ptCartridge->wCHRSize = ptInfo->wCHRROMSize;
+        ptCartridge->bCHRWritable = false;
+    } else {
+        ptCartridge->pchCHRMemory = pchRAM + ptCartridge->wPRGRAMSize;
+        ptCartridge->wCHRSize = chr_ram_size(ptInfo);
+        ptCartridge->bCHRWritable = true;
     }
 
-    //! generate mask
-    ptCartridge->wCHRAddressMask = wCHRSize - 1;
-    ptCartridge->wPRGAddressMask = wPRGSize - 1;
-    
-    memset(ptCartridge->chCHRData, 0, 0x3000);
-    
+    mapper_set_mirroring(ptCartridge, ptInfo->chMirror);
+
+    //! 0x0000-0x5FFF is not located on the cartridge, 0x6000-0x7FFF is the PRG-RAM
+    memset(ptCartridge->pchPRGBank, 0, sizeof(ptCartridge->pchPRGBank));
+    ptCartridge->pchPRGBank[3] = (uint8_t *)cartridge_no_prg_ram;
+    mapper_set_prg_ram_8k(ptCartridge, 0);
+
+    memset(&ptCartridge->tMapper, 0, sizeof(ptCartridge->tMapper));
+    ptCartridge->ptMapper->fnReset(ptCartridge);
+
     return ok;
 }
 
 //! \brief access cpu memory bus
 uint_fast16_t cartridge_read_prg(cartridge_t *cartridge, uint_fast16_t hwAddress) {
+    uint_fast16_t hwOffset = hwAddress & 0x1FFF;
+    uint8_t *pchBank = cartridge->pchPRGBank[hwAddress >> 13];
+    uint8_t *pchNext;
 
-    if (hwAddress >= 0x8000) {
-        return *(uint16_t*)&cartridge->pchPRGMemory[hwAddress & cartridge->wPRGAddressMask];
-    }    
-    
-    return *(uint16_t*)&cartridge->chIOData[hwAddress & 0x1FFF];
+    if (hwOffset != 0x1FFF) {
+        return *(uint16_t*)&pchBank[hwOffset];
+    }
+
+    //! the upper byte of the 16bit access is located in the next bank
+    pchNext = cartridge->pchPRGBank[((hwAddress + 1) >> 13) & 0x07];
+    return pchBank[0x1FFF] | ((NULL != pchNext) ? (pchNext[0] << 8) : 0);
 }
 
 void cartridge_write_prg(cartridge_t *cartridge, uint_fast16_t hwAddress, uint_fast8_t value) {
 
     if (hwAddress >= 0x8000) {
-        cartridge->pchPRGMemory[ hwAddress & cartridge->wPRGAddressMask] = value;
-    } else {
-        cartridge->chIOData[hwAddress & 0x1fff] = value;
+        //! the ROM itself is read only, the write goes to the mapper registers
+        if (NULL != cartridge->ptMapper->fnWrite) {
+            cartridge->ptMapper->fnWrite(cartridge, hwAddress, value);
+        }
+    } else if (cartridge->wPRGRAMSize) {
+        cartridge->pchPRGBank[3][hwAddress & 0x1FFF] = value;
     }
   
 }
 
-//! \brief name table mirroring look up table
-const static uint_fast8_t mirror_lookup[20] = {
-    0,0,1,1,                //!< vertical mirroring
-    0,1,0,1,                //!< horizontal mirroring
-    0,0,0,0,                //!< single screen mirroring 0
-    1,1,1,1,                //!< single screen mirroring 1
-    0,1,2,3                 //!< Full/No mirroring
-};
+//! \brief direct access to a 256 byte page of the cpu memory bus (0x6000-0xFFFF)
+uint8_t *cartridge_get_prg_page(cartridge_t *cartridge, uint_fast16_t hwAddress) {
+    uint8_t *pchBank = cartridge->pchPRGBank[(hwAddress >> 13) & 0x07];
 
+    if (NULL == pchBank) {
+        return NULL;
+    }
+    return &pchBank[hwAddress & 0x1F00];
+}
 
-int mirror_address (int mode, int address) {
-  address=address%0x1000;
-  return mirror_lookup[mode*4+(address/0x400)]*0x400+(address%0x400);
+//! \brief direct access to a 1KByte bank of the pattern tables (0x0000-0x1FFF)
+uint8_t *cartridge_get_chr_bank(cartridge_t *cartridge, uint_fast16_t hwAddress) {
+    return cartridge->pchCHRBank[(hwAddress >> 10) & 0x07];
 }
 
 //! \brief access ppu memory bus
 uint_fast8_t cartridge_read_chr(cartridge_t *cartridge, uint_fast16_t hwAddress) {
     if (hwAddress <0x2000) {
-        return cartridge->pchCHRMemory[hwAddress & cartridge->wCHRAddressMask];
+        return cartridge->pchCHRBank[hwAddress >> 10][hwAddress & 0x3FF];
     } else if (hwAddress<0x3F00) {
-        return cartridge->chCHRData[0x2000+mirror_address(cartridge->chMirror, hwAddress)%2048];
+        return cartridge->pchNameTable[(hwAddress >> 10) & 0x03][hwAddress & 0x3FF];
     }
     // TODO: assert
     return 0;
@@ -119,17 +271,56 @@ uint_fast8_t cartridge_read_chr(cartridge_t *cartridge, uint_fast16_t hwAddress)
 
 void cartridge_write_chr(cartridge_t *cartridge, uint_fast16_t hwAddress, uint_fast8_t value) {
     if (hwAddress < 0x2000) {
-        cartridge->pchCHRMemory[hwAddress & cartridge->wCHRAddressMask] = value;
+        if (cartridge->bCHRWritable) {
+            cartridge->pchCHRBank[hwAddress >> 10][hwAddress & 0x3FF] = value;
+        }
     } else if (hwAddress<0x3F00) {
-        cartridge->chCHRData[0x2000+mirror_address(cartridge->chMirror, hwAddress)%2048] = value;
+        cartridge->pchNameTable[(hwAddress >> 10) & 0x03][hwAddress & 0x3FF] = value;
     } 
 }
 
-cartridge_err_t cartridge_init(nes_t *nes, cartridge_t *cartridge, uint8_t *pchData, uint_fast32_t wSize) {
+//! \brief the ppu changed the way it fetches pattern data, \see mapper_t.fnPPUSetup
+void cartridge_ppu_setup(cartridge_t *cartridge, uint_fast64_t dwCycle, uint_fast32_t wDot,
+                         uint_fast8_t chPPUCtrl, uint_fast8_t chPPUMask) {
+    if (NULL != cartridge->ptMapper && NULL != cartridge->ptMapper->fnPPUSetup) {
+        cartridge->ptMapper->fnPPUSetup(cartridge, dwCycle, wDot, chPPUCtrl, chPPUMask);
+    }
+}
+
+uint_fast32_t cartridge_battery_ram_size(const cartridge_t *cartridge) {
+    return cartridge->tInfo.bBattery ? cartridge->wPRGRAMSize : 0;
+}
+
+cartridge_err_t cartridge_attach_battery_ram(cartridge_t *cartridge, uint8_t *pchRAM, uint_fast32_t wSize) {
+    uint_fast32_t wOffset;
+
+    if (NULL == pchRAM) {
+        return err_illegal_pointer;
+    }
+    if (0 == cartridge_battery_ram_size(cartridge)) {
+        return err_illegal_parameter;
+    }
+    if (wSize < cartridge->wPRGRAMSize) {
+        return err_illegal_size;
+    }
+
+    //! keep the bank selected by the mapper
+    wOffset = cartridge->pchPRGBank[3] - cartridge->pchPRGRAM;
+    cartridge->pchPRGRAM = pchRAM;
+    cartridge->pchPRGBank[3] = pchRAM + wOffset;
+    return ok;
+}
+
+cartridge_err_t cartridge_init(nes_t *nes, cartridge_t *cartridge, const uint8_t *pchData, uint_fast32_t wSize,
+                               uint8_t *pchRAM, uint_fast32_t wRAMSize) {
     nes->cartridge.internal = cartridge;
     nes->cartridge.read_prg = cartridge_read_prg;
     nes->cartridge.write_prg = cartridge_write_prg;
     nes->cartridge.read_chr = cartridge_read_chr;
     nes->cartridge.write_chr = cartridge_write_chr;
-    return cartridge_load(cartridge, pchData, wSize);
+    nes->cartridge.get_prg_page = cartridge_get_prg_page;
+    nes->cartridge.get_chr_bank = cartridge_get_chr_bank;
+    nes->cartridge.ppu_setup = cartridge_ppu_setup;
+    cartridge->ptCPU = &nes->cpu;
+    return cartridge_load(cartridge, pchData, wSize, pchRAM, wRAMSize);
 }
\ No newline at end of file
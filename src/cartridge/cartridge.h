@@ -2,6 +2,9 @@
 #define CARTRIDGE_H
 
 #include <stdint.h>
+#include <stdbool.h>
+#include "mapper.h"
+#include "cpu6502.h"
 #include "jeg_cfg.h"
 
 struct nes_t; 
@@ -40,16 +43,24 @@ typedef struct {
         struct {
             union {
                 struct {
-                    uint8_t                         : 4;
+                    uint8_t    VSUnisystem          : 1;
+                    uint8_t    PlayChoice10         : 1;
+                    uint8_t    HeaderFormat         : 2;                        //!< INES_FORMAT_NES20 for a NES 2.0 header
                     uint8_t    MapperHigh           : 4;                        //!< four upper bits of the mapper number
                 };
                 uint8_t chROMCTRL2;                                             //!< ROM control 2
             };
             
-            uint8_t ch8KRAMBankCount;                                           //!< number of 8 KB RAM Banks, assume 1 page of RAM when this is zero.
-            uint8_t                                 : 8;
-            uint8_t                                 : 8;
-            uint8_t                                 : 8;
+            union {
+                uint8_t ch8KRAMBankCount;                                       //!< number of 8 KB RAM Banks, assume 1 page of RAM when this is zero.
+                struct {
+                    uint8_t    MapperHighest        : 4;                        //!< NES 2.0: bits 8-11 of the mapper number
+                    uint8_t    Submapper            : 4;                        //!< NES 2.0
+                };
+            };
+            uint8_t chROMSizeHigh;                                              //!< NES 2.0: upper bits of the PRG (0-3) and CHR (4-7) ROM size
+            uint8_t chPRGRAMShift;                                              //!< NES 2.0: PRG-RAM (0-3) and battery backed PRG-RAM (4-7), 64 << n bytes
+            uint8_t chCHRRAMShift;                                              //!< NES 2.0: CHR-RAM (0-3) and battery backed CHR-RAM (4-7), 64 << n bytes
             uint8_t                                 : 8;
             uint8_t                                 : 8;
             uint8_t                                 : 8;
@@ -59,19 +70,90 @@ typedef struct {
         uint8_t chDiskDudeString[9];                                            //!< "DiskDude!"                                               
     };
 }iNES_t;
+
+#define INES_FORMAT_NES20                       2
+//! @}
+
+//! \name name table mirroring modes (cartridge_t.chMirror)
+//! @{
+#define CARTRIDGE_MIRROR_HORIZONTAL             0
+#define CARTRIDGE_MIRROR_VERTICAL               1
+#define CARTRIDGE_MIRROR_SINGLE_SCREEN_0        2
+#define CARTRIDGE_MIRROR_SINGLE_SCREEN_1        3
+#define CARTRIDGE_MIRROR_FOUR_SCREEN            4
 //! @}
 
+//! \brief the board as described by the header (and corrected by the ROM database)
+typedef struct {
+    uint_fast16_t   hwMapper;
+    uint_fast8_t    chSubmapper;
+    uint_fast32_t   wPRGROMSize;
+    uint_fast32_t   wCHRROMSize;
+    uint_fast32_t   wPRGRAMSize;                                                //!< including battery backed PRG-RAM
+    uint_fast32_t   wCHRRAMSize;
+    uint_fast8_t    chMirror;                                                   //!< see CARTRIDGE_MIRROR_xxx
+    bool            bBattery;
+    bool            bTrainer;
+    bool            bNES20;                                                     //!< NES 2.0 header, sizes are exact
+} cartridge_info_t;
+
+/*! \brief ROM database entry, corrects the iNES header of known ROMs
+ *! \note  the ROM sizes and with them the CHR-RAM are kept, the file size confirms them
+ */
 typedef struct {
-  uint_fast32_t     wPRGAddressMask;
+    uint32_t        wCRC32;                                                     //!< crc32 of PRG-ROM and CHR-ROM (without header and trainer)
+    uint16_t        hwMapper;
+    uint8_t         chMirror;
+    bool            bBattery;
+    uint32_t        wPRGRAMSize;
+} cartridge_db_entry_t;
+
+#if JEG_USE_ROM_DATABASE == ENABLED
+extern const cartridge_db_entry_t cartridge_db[];
+extern const uint_fast32_t cartridge_db_size;
+#endif
+
+typedef struct cartridge_t {
+  uint8_t          *pchPRGBank[8];                                              //!< 8KByte banks of the cpu bus, used from 0x6000
+  uint8_t          *pchCHRBank[8];                                              //!< 1KByte banks of the ppu bus (0x0000-0x1FFF)
   uint8_t          *pchPRGMemory;
-  uint_fast32_t     wCHRAddressMask;
+  uint_fast32_t     wPRGSize;
   uint8_t          *pchCHRMemory;
-  uint8_t           chIOData  [0x2000];
-  uint8_t           chCHRData [0x3000];
-  uint_fast8_t      chMapper;
-  uint_fast8_t      chMirror;                                                   //!< 0-horizontal, 1-vertical, 2-none
+  uint_fast32_t     wCHRSize;
+  bool              bCHRWritable;                                               //!< CHR-RAM instead of CHR-ROM
+  const mapper_t   *ptMapper;
+  mapper_state_t    tMapper;
+  cpu6502_t        *ptCPU;                                                      //!< for boards raising an irq
+  cartridge_info_t  tInfo;
+  uint8_t          *pchPRGRAM;                                                  //!< NULL if the board has none
+  uint_fast32_t     wPRGRAMSize;
+  uint8_t          *pchNameTableRAM;                                            //!< 2KByte, 4KByte for four screen boards
+  uint_fast8_t      chNameTableCount;                                           //!< 1KByte physical name tables in pchNameTableRAM (2 or 4)
+  uint_fast8_t      chMirror;                                                   //!< see CARTRIDGE_MIRROR_xxx
+  uint8_t          *pchNameTable[4];                                            //!< 1KByte name table pages of 0x2000-0x2FFF
+  uint8_t           chNameTablePage[4];                                         //!< physical name table (0-3) of each page
 } cartridge_t;
 
-extern cartridge_err_t cartridge_init(struct nes_t *nes, cartridge_t *cartridge, uint8_t *rom_image, uint_fast32_t size);
+//! \brief read the header of a ROM image (NES 2.0 or iNES, corrected by the ROM database)
+extern cartridge_err_t cartridge_parse(const uint8_t *rom_image, uint_fast32_t size, cartridge_info_t *info);
+
+//! \brief size of the RAM block the board needs (PRG-RAM, CHR-RAM and name tables), 0 for an invalid image
+extern uint_fast32_t cartridge_ram_size(const uint8_t *rom_image, uint_fast32_t size);
+
+/*! \brief the ROM image is referenced (not copied), it has to stay valid as long as the cartridge is used
+ *! \param ram RAM block of (at least) cartridge_ram_size() bytes, owned by the caller
+ */
+extern cartridge_err_t cartridge_init(struct nes_t *nes, cartridge_t *cartridge, const uint8_t *rom_image, uint_fast32_t size,
+                                      uint8_t *ram, uint_fast32_t ram_size);
+
+//! \brief size of the battery backed PRG-RAM, 0 if the board has no battery
+extern uint_fast32_t cartridge_battery_ram_size(const cartridge_t *cartridge);
+
+/*! \brief use a host provided buffer (e.g. a mapped save file, see save.h) as PRG-RAM
+ *!        of a battery backed board, its content is kept. The buffer replaces the
+ *!        PRG-RAM part of the RAM block until the next cartridge_init().
+ *! \param size at least cartridge_battery_ram_size() bytes
+ */
+extern cartridge_err_t cartridge_attach_battery_ram(cartridge_t *cartridge, uint8_t *ram, uint_fast32_t size);
 
 #endif
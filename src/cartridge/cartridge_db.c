@@ -0,0 +1,39 @@
+#include "cartridge.h"
+#include "jeg_cfg.h"
+
+#if JEG_USE_ROM_DATABASE == ENABLED
+/*! \brief ROMs known to have a wrong iNES header
+ *! \note  the key is the crc32 of PRG-ROM and CHR-ROM (as used by NesCartDB), the
+ *!        entries follow the iNES correction list of FCEUX. UxROM and CNROM boards
+ *!        have no PRG-RAM, MMC1 switches the mirroring itself.
+ */
+const cartridge_db_entry_t cartridge_db[] = {
+    /* wCRC32       hwMapper    chMirror                        bBattery    wPRGRAMSize */
+    {0x37BA3261,    1,          CARTRIDGE_MIRROR_HORIZONTAL,    false,      0x2000},    //!< Back to the Future Part II & III
+    {0xF6FA4453,    1,          CARTRIDGE_MIRROR_HORIZONTAL,    false,      0x2000},    //!< Bigfoot
+    {0xA5E8D2CD,    1,          CARTRIDGE_MIRROR_HORIZONTAL,    false,      0x2000},    //!< Breakthru
+    {0x57C12280,    1,          CARTRIDGE_MIRROR_HORIZONTAL,    false,      0x2000},    //!< Demon Sword
+    {0xF74DFC91,    1,          CARTRIDGE_MIRROR_HORIZONTAL,    false,      0x2000},    //!< Win, Lose or Draw
+
+    {0x9EA1DC76,    2,          CARTRIDGE_MIRROR_HORIZONTAL,    false,      0},         //!< Rainbow Islands
+    {0x6D65CAC6,    2,          CARTRIDGE_MIRROR_HORIZONTAL,    false,      0},         //!< Terra Cresta
+    {0xE1B260DA,    2,          CARTRIDGE_MIRROR_VERTICAL,      false,      0},         //!< Argos no Senshi
+    {0x266CE198,    2,          CARTRIDGE_MIRROR_VERTICAL,      false,      0},         //!< City Adventure Touch
+    {0x804F898A,    2,          CARTRIDGE_MIRROR_VERTICAL,      false,      0},         //!< Dragon Unit
+    {0x55773880,    2,          CARTRIDGE_MIRROR_VERTICAL,      false,      0},         //!< Gilligan's Island
+    {0x6E0EB43E,    2,          CARTRIDGE_MIRROR_VERTICAL,      false,      0},         //!< Puss 'n Boots
+    {0x2BB6A0F8,    2,          CARTRIDGE_MIRROR_VERTICAL,      false,      0},         //!< Sherlock Holmes
+    {0x28C11D24,    2,          CARTRIDGE_MIRROR_VERTICAL,      false,      0},         //!< Sukeban Deka 3
+    {0x02863604,    2,          CARTRIDGE_MIRROR_VERTICAL,      false,      0},         //!< Sukeban Deka 3
+
+    {0xDBF90772,    3,          CARTRIDGE_MIRROR_HORIZONTAL,    false,      0},         //!< Alpha Mission
+    {0xD858033D,    3,          CARTRIDGE_MIRROR_HORIZONTAL,    false,      0},         //!< Armored Scrum Object
+    {0xCF322BB3,    3,          CARTRIDGE_MIRROR_VERTICAL,      false,      0},         //!< John Elway's Quarterback
+    {0x9BDE3267,    3,          CARTRIDGE_MIRROR_VERTICAL,      false,      0},         //!< Adventures of Dino Riki
+    {0x02CC3973,    3,          CARTRIDGE_MIRROR_VERTICAL,      false,      0},         //!< Ninja Kid
+    {0xBC065FC3,    3,          CARTRIDGE_MIRROR_VERTICAL,      false,      0},         //!< Pipe Dream
+    {0}                                                                                 //!< end of table
+};
+
+const uint_fast32_t cartridge_db_size = UBOUND(cartridge_db) - 1;
+#endif
@@ -0,0 +1,95 @@
+#include "mapper.h"
+#include "cartridge.h"
+
+static const mapper_t *mapper_list[] = {
+    &mapper_nrom,
+    &mapper_mmc1,
+    &mapper_uxrom,
+    &mapper_cnrom,
+    &mapper_axrom,
+    &mapper_mmc3,
+};
+
+const mapper_t *mapper_find(uint_fast16_t hwNumber)
+{
+    for (uint_fast8_t n = 0; n < UBOUND(mapper_list); n++) {
+        if (mapper_list[n]->hwNumber == hwNumber) {
+            return mapper_list[n];
+        }
+    }
+    return NULL;
+}
+
+//! \param chSlot 0-3 for 0x8000, 0xA000, 0xC000 and 0xE000
+void mapper_set_prg_8k(cartridge_t *ptCartridge, uint_fast8_t chSlot, uint_fast32_t wBank)
+{
+    wBank %= ptCartridge->wPRGSize >> 13;
+    ptCartridge->pchPRGBank[4 + chSlot] = &ptCartridge->pchPRGMemory[wBank << 13];
+}
+
+//! \param chSlot 0 for 0x8000, 1 for 0xC000
+void mapper_set_prg_16k(cartridge_t *ptCartridge, uint_fast8_t chSlot, uint_fast32_t wBank)
+{
+    mapper_set_prg_8k(ptCartridge, chSlot * 2, wBank * 2);
+    mapper_set_prg_8k(ptCartridge, chSlot * 2 + 1, wBank * 2 + 1);
+}
+
+void mapper_set_prg_32k(cartridge_t *ptCartridge, uint_fast32_t wBank)
+{
+    mapper_set_prg_16k(ptCartridge, 0, wBank * 2);
+    mapper_set_prg_16k(ptCartridge, 1, wBank * 2 + 1);
+}
+
+//! \param chSlot 0-7 for 0x0000, 0x0400, ... 0x1C00
+void mapper_set_chr_1k(cartridge_t *ptCartridge, uint_fast8_t chSlot, uint_fast32_t wBank)
+{
+    wBank %= ptCartridge->wCHRSize >> 10;
+    ptCartridge->pchCHRBank[chSlot] = &ptCartridge->pchCHRMemory[wBank << 10];
+}
+
+//! \param chSlot 0 for 0x0000, 1 for 0x1000
+void mapper_set_chr_4k(cartridge_t *ptCartridge, uint_fast8_t chSlot, uint_fast32_t wBank)
+{
+    for (uint_fast8_t n = 0; n < 4; n++) {
+        mapper_set_chr_1k(ptCartridge, chSlot * 4 + n, wBank * 4 + n);
+    }
+}
+
+void mapper_set_chr_8k(cartridge_t *ptCartridge, uint_fast32_t wBank)
+{
+    mapper_set_chr_4k(ptCartridge, 0, wBank * 2);
+    mapper_set_chr_4k(ptCartridge, 1, wBank * 2 + 1);
+}
+
+//! \brief PRG-RAM bank at 0x6000, boards without PRG-RAM are left unchanged
+void mapper_set_prg_ram_8k(cartridge_t *ptCartridge, uint_fast32_t wBank)
+{
+    if (0 == ptCartridge->wPRGRAMSize) {
+        return ;
+    }
+    wBank %= ptCartridge->wPRGRAMSize >> 13;
+    ptCartridge->pchPRGBank[3] = &ptCartridge->pchPRGRAM[wBank << 13];
+}
+
+void mapper_set_mirroring(cartridge_t *ptCartridge, uint_fast8_t chMirror)
+{
+    //! physical name table of each 1KByte page, indexed by CARTRIDGE_MIRROR_xxx
+    static const uint8_t chPageLookup[5][4] = {
+        {0, 0, 1, 1},                                                           //!< horizontal
+        {0, 1, 0, 1},                                                           //!< vertical
+        {0, 0, 0, 0},                                                           //!< single screen 0
+        {1, 1, 1, 1},                                                           //!< single screen 1
+        {0, 1, 2, 3},                                                           //!< four screen, the board adds 2KByte (see cartridge_ram_size())
+    };
+
+    ptCartridge->chMirror = chMirror;
+    for (uint_fast8_t n = 0; n < 4; n++) {
+        ptCartridge->chNameTablePage[n] = chPageLookup[chMirror][n];
+        ptCartridge->pchNameTable[n] = &ptCartridge->pchNameTableRAM[chPageLookup[chMirror][n] * 0x400];
+    }
+}
+
+uint_fast8_t mapper_bus_conflict(cartridge_t *ptCartridge, uint_fast16_t hwAddress, uint_fast8_t chData)
+{
+    return chData & ptCartridge->pchPRGBank[hwAddress >> 13][hwAddress & 0x1FFF];
+}
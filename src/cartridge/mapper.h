@@ -0,0 +1,92 @@
+#ifndef MAPPER_H
+#define MAPPER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "jeg_cfg.h"
+
+struct cartridge_t;
+
+//! \name register state of the supported mappers
+//! @{
+typedef struct {
+    uint8_t chShift;                                                            //!< serial shift register
+    uint8_t chShiftCount;                                                       //!< number of bits shifted in
+    uint8_t chControl;                                                          //!< mirroring, PRG and CHR bank mode
+    uint8_t chCHRBank0;
+    uint8_t chCHRBank1;
+    uint8_t chPRGBank;
+} mapper_mmc1_t;
+
+typedef struct {
+    uint8_t chBankSelect;                                                       //!< register index, PRG and CHR bank mode
+    uint8_t chBank[8];                                                          //!< R0-R5 CHR, R6-R7 PRG banks
+    uint8_t chIRQLatch;
+    uint8_t chIRQCounter;
+    bool bIRQReload;
+    bool bIRQEnabled;
+    uint16_t hwClockDot;                                                        //!< dot of a rendered scanline the counter is clocked at, 0: never
+    uint32_t wDot;                                                              //!< ppu position (scanline * 341 + dot) at dwCycle
+    uint64_t dwCycle;                                                           //!< cpu cycle the irq counter is up to date with
+} mapper_mmc3_t;
+
+typedef union {
+    mapper_mmc1_t   tMMC1;
+    mapper_mmc3_t   tMMC3;
+    uint8_t         chRegister[16];
+} mapper_state_t;
+//! @}
+
+/*! \brief mapper plug-in interface
+ *! \note  a mapper only changes the bank pointer tables of the cartridge (and
+ *!        the name table pages), the memory accesses never go through the mapper
+ */
+typedef struct {
+    uint_fast16_t hwNumber;                                                     //!< iNES mapper number
+    const char *pchName;
+
+    //! power-up state, has to set up all bank pointers
+    void (*fnReset) (struct cartridge_t *ptCartridge);
+
+    //! cpu write to 0x8000-0xFFFF, NULL if the board has no registers
+    void (*fnWrite) (struct cartridge_t *ptCartridge, uint_fast16_t hwAddress, uint_fast8_t chData);
+
+    /*! the ppu changed the way it fetches from the pattern tables (ppuctrl / ppumask),
+     *! NULL if the board does not watch the ppu bus
+     */
+    void (*fnPPUSetup) (struct cartridge_t *ptCartridge, uint_fast64_t dwCycle, uint_fast32_t wDot,
+                        uint_fast8_t chPPUCtrl, uint_fast8_t chPPUMask);
+} mapper_t;
+
+//! \name supported mappers
+//! @{
+extern const mapper_t mapper_nrom;
+extern const mapper_t mapper_mmc1;
+extern const mapper_t mapper_uxrom;
+extern const mapper_t mapper_cnrom;
+extern const mapper_t mapper_axrom;
+extern const mapper_t mapper_mmc3;
+//! @}
+
+//! \brief find a mapper by its iNES number, NULL if it is not supported
+extern const mapper_t *mapper_find(uint_fast16_t hwNumber);
+
+//! \name bank switching helpers, bank numbers wrap around the memory size
+//! @{
+extern void mapper_set_prg_8k(struct cartridge_t *ptCartridge, uint_fast8_t chSlot, uint_fast32_t wBank);
+extern void mapper_set_prg_16k(struct cartridge_t *ptCartridge, uint_fast8_t chSlot, uint_fast32_t wBank);
+extern void mapper_set_prg_32k(struct cartridge_t *ptCartridge, uint_fast32_t wBank);
+extern void mapper_set_chr_1k(struct cartridge_t *ptCartridge, uint_fast8_t chSlot, uint_fast32_t wBank);
+extern void mapper_set_chr_4k(struct cartridge_t *ptCartridge, uint_fast8_t chSlot, uint_fast32_t wBank);
+extern void mapper_set_chr_8k(struct cartridge_t *ptCartridge, uint_fast32_t wBank);
+extern void mapper_set_prg_ram_8k(struct cartridge_t *ptCartridge, uint_fast32_t wBank);
+//! @}
+
+//! \brief select the name table mirroring (CARTRIDGE_MIRROR_xxx), rebuilds the name table pages
+extern void mapper_set_mirroring(struct cartridge_t *ptCartridge, uint_fast8_t chMirror);
+
+//! \brief value seen by the board when the cpu write collides with the ROM output
+extern uint_fast8_t mapper_bus_conflict(struct cartridge_t *ptCartridge, uint_fast16_t hwAddress, uint_fast8_t chData);
+
+#endif
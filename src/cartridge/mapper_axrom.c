@@ -0,0 +1,26 @@
+#include "mapper.h"
+#include "cartridge.h"
+
+//! \brief AxROM (mapper 7): switchable 32KByte PRG, single screen mirroring, CHR-RAM
+
+static void axrom_reset(cartridge_t *ptCartridge)
+{
+    mapper_set_prg_32k(ptCartridge, 0);
+    mapper_set_chr_8k(ptCartridge, 0);
+    mapper_set_mirroring(ptCartridge, CARTRIDGE_MIRROR_SINGLE_SCREEN_0);
+}
+
+static void axrom_write(cartridge_t *ptCartridge, uint_fast16_t hwAddress, uint_fast8_t chData)
+{
+    //! ANROM/AOROM have no bus conflicts, so they are not emulated
+    mapper_set_prg_32k(ptCartridge, chData & 0x0F);
+    mapper_set_mirroring(ptCartridge, (chData & 0x10)  ? CARTRIDGE_MIRROR_SINGLE_SCREEN_1
+                                                        : CARTRIDGE_MIRROR_SINGLE_SCREEN_0);
+}
+
+const mapper_t mapper_axrom = {
+    .hwNumber   = 7,
+    .pchName    = "AxROM",
+    .fnReset    = axrom_reset,
+    .fnWrite    = axrom_write,
+};
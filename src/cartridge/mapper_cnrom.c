@@ -0,0 +1,23 @@
+#include "mapper.h"
+#include "cartridge.h"
+
+//! \brief CNROM (mapper 3): fixed PRG, switchable 8KByte CHR
+
+static void cnrom_reset(cartridge_t *ptCartridge)
+{
+    mapper_set_prg_32k(ptCartridge, 0);
+    mapper_set_chr_8k(ptCartridge, 0);
+}
+
+static void cnrom_write(cartridge_t *ptCartridge, uint_fast16_t hwAddress, uint_fast8_t chData)
+{
+    chData = mapper_bus_conflict(ptCartridge, hwAddress, chData);
+    mapper_set_chr_8k(ptCartridge, chData);
+}
+
+const mapper_t mapper_cnrom = {
+    .hwNumber   = 3,
+    .pchName    = "CNROM",
+    .fnReset    = cnrom_reset,
+    .fnWrite    = cnrom_write,
+};
@@ -0,0 +1,114 @@
+#include "mapper.h"
+#include "cartridge.h"
+
+//! \brief MMC1 (mapper 1): serial loaded registers, 16/32KByte PRG and 4/8KByte CHR banks
+
+static const uint_fast8_t mmc1_mirror[4] = {
+    CARTRIDGE_MIRROR_SINGLE_SCREEN_0,
+    CARTRIDGE_MIRROR_SINGLE_SCREEN_1,
+    CARTRIDGE_MIRROR_VERTICAL,
+    CARTRIDGE_MIRROR_HORIZONTAL,
+};
+
+static void mmc1_update_banks(cartridge_t *ptCartridge)
+{
+    mapper_mmc1_t *ptMMC1 = &ptCartridge->tMapper.tMMC1;
+    uint_fast8_t chPRGBank = ptMMC1->chPRGBank & 0x0F;
+    uint_fast8_t chOuterBank = 0;
+
+    //! SUROM: 512KByte PRG, the CHR register selects the 256KByte half
+    if (ptCartridge->wPRGSize > 0x40000) {
+        chOuterBank = ptMMC1->chCHRBank0 & 0x10;
+    }
+
+    switch ((ptMMC1->chControl >> 2) & 0x03) {
+        case 0:
+        case 1:                                                                 //!< 32KByte
+            mapper_set_prg_16k(ptCartridge, 0, chOuterBank | (chPRGBank & 0x0E));
+            mapper_set_prg_16k(ptCartridge, 1, chOuterBank | (chPRGBank & 0x0E) | 1);
+            break;
+        case 2:                                                                 //!< first bank fixed at 0x8000
+            mapper_set_prg_16k(ptCartridge, 0, chOuterBank);
+            mapper_set_prg_16k(ptCartridge, 1, chOuterBank | chPRGBank);
+            break;
+        case 3:                                                                 //!< last bank fixed at 0xC000
+            mapper_set_prg_16k(ptCartridge, 0, chOuterBank | chPRGBank);
+            mapper_set_prg_16k(ptCartridge, 1, chOuterBank | 0x0F);
+            break;
+    }
+
+    //! SOROM (16KByte) / SXROM (32KByte): the CHR register selects the PRG-RAM bank
+    if (ptCartridge->wPRGRAMSize > 0x4000) {
+        mapper_set_prg_ram_8k(ptCartridge, (ptMMC1->chCHRBank0 >> 2) & 0x03);
+    } else {
+        mapper_set_prg_ram_8k(ptCartridge, (ptMMC1->chCHRBank0 >> 3) & 0x01);
+    }
+
+    if (ptMMC1->chControl & 0x10) {                                             //!< two 4KByte banks
+        mapper_set_chr_4k(ptCartridge, 0, ptMMC1->chCHRBank0);
+        mapper_set_chr_4k(ptCartridge, 1, ptMMC1->chCHRBank1);
+    } else {                                                                    //!< one 8KByte bank
+        mapper_set_chr_4k(ptCartridge, 0, ptMMC1->chCHRBank0 & 0x1E);
+        mapper_set_chr_4k(ptCartridge, 1, ptMMC1->chCHRBank0 | 0x01);
+    }
+}
+
+static void mmc1_reset(cartridge_t *ptCartridge)
+{
+    mapper_mmc1_t *ptMMC1 = &ptCartridge->tMapper.tMMC1;
+
+    ptMMC1->chShift         = 0;
+    ptMMC1->chShiftCount    = 0;
+    ptMMC1->chControl       = 0x0C;                                             //!< last bank fixed at 0xC000
+    ptMMC1->chCHRBank0      = 0;
+    ptMMC1->chCHRBank1      = 0;
+    ptMMC1->chPRGBank       = 0;
+
+    //! the mirroring stays as given by the header until the control register is written
+    mmc1_update_banks(ptCartridge);
+}
+
+static void mmc1_write(cartridge_t *ptCartridge, uint_fast16_t hwAddress, uint_fast8_t chData)
+{
+    mapper_mmc1_t *ptMMC1 = &ptCartridge->tMapper.tMMC1;
+
+    if (chData & 0x80) {
+        ptMMC1->chShift         = 0;
+        ptMMC1->chShiftCount    = 0;
+        ptMMC1->chControl      |= 0x0C;
+        mmc1_update_banks(ptCartridge);
+        return ;
+    }
+
+    ptMMC1->chShift |= (chData & 0x01) << ptMMC1->chShiftCount;
+    if (++ptMMC1->chShiftCount < 5) {
+        return ;
+    }
+
+    switch ((hwAddress >> 13) & 0x03) {
+        case 0:
+            ptMMC1->chControl = ptMMC1->chShift;
+            mapper_set_mirroring(ptCartridge, mmc1_mirror[ptMMC1->chShift & 0x03]);
+            break;
+        case 1:
+            ptMMC1->chCHRBank0 = ptMMC1->chShift;
+            break;
+        case 2:
+            ptMMC1->chCHRBank1 = ptMMC1->chShift;
+            break;
+        case 3:
+            ptMMC1->chPRGBank = ptMMC1->chShift;
+            break;
+    }
+    ptMMC1->chShift         = 0;
+    ptMMC1->chShiftCount    = 0;
+
+    mmc1_update_banks(ptCartridge);
+}
+
+const mapper_t mapper_mmc1 = {
+    .hwNumber   = 1,
+    .pchName    = "MMC1",
+    .fnReset    = mmc1_reset,
+    .fnWrite    = mmc1_write,
+};
@@ -0,0 +1,241 @@
+#include "mapper.h"
+#include "cartridge.h"
+
+/*! \brief MMC3 (mapper 4): 8KByte PRG and 1/2KByte CHR banks, scanline counter irq
+ *!
+ *! The irq counter is clocked by the rising edge of PPU A12. Instead of watching
+ *! every pattern fetch, the edge is taken from the PPU setup: with rendering
+ *! enabled there is exactly one clock per rendered scanline (and the pre-render
+ *! line) at a fixed dot. So the counter is only brought up to date when the cpu
+ *! talks to the mapper (or the PPU setup changes) and the cycle of the next irq
+ *! is calculated in advance and handed to the cpu.
+ */
+
+#define MMC3_FRAME_DOTS                 (341 * 262)
+#define MMC3_CLOCKS_PER_FRAME           241                                     //!< scanlines 0-239 and the pre-render line
+#define MMC3_PRE_RENDER_LINE            261
+
+//! \brief number of counter clocks from the start of the frame up to (including) dot wPosition
+static uint_fast32_t mmc3_clocks_in_frame(uint_fast16_t hwClockDot, uint_fast32_t wPosition)
+{
+    uint_fast32_t wClocks;
+
+    if (wPosition < hwClockDot) {
+        return 0;
+    }
+
+    wClocks = (wPosition - hwClockDot) / 341 + 1;
+    if (wClocks > 240) {
+        wClocks = 240 + (wPosition >= MMC3_PRE_RENDER_LINE * 341 + hwClockDot);
+    }
+    return wClocks;
+}
+
+//! \brief number of counter clocks from dot 0 of the first frame up to (including) dwPosition
+static uint_fast64_t mmc3_clocks_until(uint_fast16_t hwClockDot, uint_fast64_t dwPosition)
+{
+    return  (dwPosition / MMC3_FRAME_DOTS) * MMC3_CLOCKS_PER_FRAME
+        +   mmc3_clocks_in_frame(hwClockDot, dwPosition % MMC3_FRAME_DOTS);
+}
+
+//! \brief apply a number of counter clocks at once, the counter runs through latch..0
+static void mmc3_clock_counter(mapper_mmc3_t *ptMMC3, uint_fast64_t dwClocks)
+{
+    if (0 == dwClocks) {
+        return ;
+    }
+
+    if (0 == ptMMC3->chIRQCounter || ptMMC3->bIRQReload) {
+        ptMMC3->chIRQCounter = ptMMC3->chIRQLatch;
+        ptMMC3->bIRQReload = false;
+    } else {
+        ptMMC3->chIRQCounter--;
+    }
+    dwClocks--;
+
+    if (dwClocks <= ptMMC3->chIRQCounter) {
+        ptMMC3->chIRQCounter -= dwClocks;
+    } else {
+        dwClocks -= ptMMC3->chIRQCounter + 1;                                   //!< clocks after the next reload
+        ptMMC3->chIRQCounter = ptMMC3->chIRQLatch - (dwClocks % (ptMMC3->chIRQLatch + 1));
+    }
+}
+
+//! \brief bring the irq counter up to date with the given cpu cycle
+static void mmc3_catch_up(mapper_mmc3_t *ptMMC3, uint_fast64_t dwCycle)
+{
+    uint_fast64_t dwEnd;
+
+    if (dwCycle <= ptMMC3->dwCycle) {
+        return ;
+    }
+
+    dwEnd = ptMMC3->wDot + (dwCycle - ptMMC3->dwCycle) * 3;
+    if (ptMMC3->hwClockDot) {
+        mmc3_clock_counter(ptMMC3,  mmc3_clocks_until(ptMMC3->hwClockDot, dwEnd)
+                                -   mmc3_clocks_until(ptMMC3->hwClockDot, ptMMC3->wDot));
+    }
+    ptMMC3->wDot = dwEnd % MMC3_FRAME_DOTS;
+    ptMMC3->dwCycle = dwCycle;
+}
+
+//! \brief calculate the cpu cycle the counter reaches zero (and the irq line is asserted)
+static void mmc3_predict_irq(cartridge_t *ptCartridge)
+{
+    mapper_mmc3_t *ptMMC3 = &ptCartridge->tMapper.tMMC3;
+    uint_fast64_t dwClock, dwPosition;
+    uint_fast32_t wClocks, wLine;
+
+    //! an asserted irq stays until it is acknowledged
+    if (ptCartridge->ptCPU->irq_cycle <= ptMMC3->dwCycle) {
+        return ;
+    }
+
+    ptCartridge->ptCPU->irq_cycle = CPU6502_IRQ_NEVER;
+    if (!ptMMC3->bIRQEnabled || 0 == ptMMC3->hwClockDot) {
+        return ;
+    }
+
+    if (0 == ptMMC3->chIRQCounter || ptMMC3->bIRQReload) {
+        wClocks = ptMMC3->chIRQLatch + 1;                                       //!< reload, then count down to zero
+    } else {
+        wClocks = ptMMC3->chIRQCounter;
+    }
+
+    //! position of the clock which is the wClocks-th one from now on
+    dwClock = mmc3_clocks_until(ptMMC3->hwClockDot, ptMMC3->wDot) + wClocks - 1;
+    wLine = dwClock % MMC3_CLOCKS_PER_FRAME;
+    if (wLine >= 240) {
+        wLine = MMC3_PRE_RENDER_LINE;
+    }
+    dwPosition =    (dwClock / MMC3_CLOCKS_PER_FRAME) * MMC3_FRAME_DOTS
+                +   wLine * 341 + ptMMC3->hwClockDot;
+
+    ptCartridge->ptCPU->irq_cycle = ptMMC3->dwCycle + (dwPosition - ptMMC3->wDot + 2) / 3;
+}
+
+static void mmc3_update_banks(cartridge_t *ptCartridge)
+{
+    mapper_mmc3_t *ptMMC3 = &ptCartridge->tMapper.tMMC3;
+    uint_fast32_t wSecondLast = (ptCartridge->wPRGSize >> 13) - 2;
+    uint_fast8_t chInvert = (ptMMC3->chBankSelect & 0x80) ? 4 : 0;
+
+    if (ptMMC3->chBankSelect & 0x40) {                                          //!< 0xC000 swappable, 0x8000 fixed
+        mapper_set_prg_8k(ptCartridge, 0, wSecondLast);
+        mapper_set_prg_8k(ptCartridge, 2, ptMMC3->chBank[6]);
+    } else {
+        mapper_set_prg_8k(ptCartridge, 0, ptMMC3->chBank[6]);
+        mapper_set_prg_8k(ptCartridge, 2, wSecondLast);
+    }
+    mapper_set_prg_8k(ptCartridge, 1, ptMMC3->chBank[7]);
+    mapper_set_prg_8k(ptCartridge, 3, wSecondLast + 1);
+
+    //! R0/R1 select 2KByte banks, R2-R5 1KByte banks; the inversion swaps both halfs
+    mapper_set_chr_1k(ptCartridge, 0 ^ chInvert, ptMMC3->chBank[0] & 0xFE);
+    mapper_set_chr_1k(ptCartridge, 1 ^ chInvert, ptMMC3->chBank[0] | 0x01);
+    mapper_set_chr_1k(ptCartridge, 2 ^ chInvert, ptMMC3->chBank[1] & 0xFE);
+    mapper_set_chr_1k(ptCartridge, 3 ^ chInvert, ptMMC3->chBank[1] | 0x01);
+    for (uint_fast8_t n = 0; n < 4; n++) {
+        mapper_set_chr_1k(ptCartridge, (4 + n) ^ chInvert, ptMMC3->chBank[2 + n]);
+    }
+}
+
+static void mmc3_reset(cartridge_t *ptCartridge)
+{
+    mapper_mmc3_t *ptMMC3 = &ptCartridge->tMapper.tMMC3;
+    static const uint8_t chBank[8] = {0, 2, 4, 5, 6, 7, 0, 1};
+
+    for (uint_fast8_t n = 0; n < 8; n++) {
+        ptMMC3->chBank[n] = chBank[n];
+    }
+    ptMMC3->chBankSelect    = 0;
+    ptMMC3->chIRQLatch      = 0;
+    ptMMC3->chIRQCounter    = 0;
+    ptMMC3->bIRQReload      = false;
+    ptMMC3->bIRQEnabled     = false;
+    ptMMC3->hwClockDot      = 0;
+    ptMMC3->wDot            = 0;
+    ptMMC3->dwCycle         = 0;
+
+    mmc3_update_banks(ptCartridge);
+}
+
+static void mmc3_write(cartridge_t *ptCartridge, uint_fast16_t hwAddress, uint_fast8_t chData)
+{
+    mapper_mmc3_t *ptMMC3 = &ptCartridge->tMapper.tMMC3;
+
+    switch (hwAddress & 0xE001) {
+        case 0x8000:
+            ptMMC3->chBankSelect = chData;
+            mmc3_update_banks(ptCartridge);
+            return ;
+        case 0x8001:
+            ptMMC3->chBank[ptMMC3->chBankSelect & 0x07] = chData;
+            mmc3_update_banks(ptCartridge);
+            return ;
+        case 0xA000:
+            if (CARTRIDGE_MIRROR_FOUR_SCREEN != ptCartridge->chMirror) {
+                mapper_set_mirroring(ptCartridge, (chData & 0x01)  ? CARTRIDGE_MIRROR_HORIZONTAL
+                                                                    : CARTRIDGE_MIRROR_VERTICAL);
+            }
+            return ;
+        case 0xA001:                                                            //!< PRG-RAM protection is not emulated
+            return ;
+    }
+
+    //! irq registers: the counter has to be up to date before it is changed
+    mmc3_catch_up(ptMMC3, ptCartridge->ptCPU->cycle_number);
+
+    switch (hwAddress & 0xE001) {
+        case 0xC000:
+            ptMMC3->chIRQLatch = chData;
+            break;
+        case 0xC001:
+            ptMMC3->chIRQCounter = 0;
+            ptMMC3->bIRQReload = true;
+            break;
+        case 0xE000:
+            ptMMC3->bIRQEnabled = false;
+            ptCartridge->ptCPU->irq_cycle = CPU6502_IRQ_NEVER;                  //!< acknowledge
+            break;
+        case 0xE001:
+            ptMMC3->bIRQEnabled = true;
+            break;
+    }
+    mmc3_predict_irq(ptCartridge);
+}
+
+/*! \brief A12 rises once per rendered scanline: at dot 260 when the sprites are
+ *!        fetched from 0x1000 (8x16 sprites are treated alike), at dot 324 when
+ *!        only the background is fetched from 0x1000
+ */
+static void mmc3_ppu_setup(cartridge_t *ptCartridge, uint_fast64_t dwCycle, uint_fast32_t wDot,
+                           uint_fast8_t chPPUCtrl, uint_fast8_t chPPUMask)
+{
+    mapper_mmc3_t *ptMMC3 = &ptCartridge->tMapper.tMMC3;
+
+    //! the cpu cycles restart after a reset, there is nothing to catch up then
+    mmc3_catch_up(ptMMC3, dwCycle);
+    ptMMC3->dwCycle = dwCycle;
+    ptMMC3->wDot = wDot;
+
+    if (0 == (chPPUMask & 0x18)) {                                              //!< rendering disabled
+        ptMMC3->hwClockDot = 0;
+    } else if (chPPUCtrl & 0x28) {                                              //!< sprite table 0x1000 or 8x16 sprites
+        ptMMC3->hwClockDot = 260;
+    } else if (chPPUCtrl & 0x10) {                                              //!< background table 0x1000
+        ptMMC3->hwClockDot = 324;
+    } else {
+        ptMMC3->hwClockDot = 0;
+    }
+
+    mmc3_predict_irq(ptCartridge);
+}
+
+const mapper_t mapper_mmc3 = {
+    .hwNumber   = 4,
+    .pchName    = "MMC3",
+    .fnReset    = mmc3_reset,
+    .fnWrite    = mmc3_write,
+    .fnPPUSetup = mmc3_ppu_setup,
+};
@@ -0,0 +1,17 @@
+#include "mapper.h"
+#include "cartridge.h"
+
+//! \brief NROM (mapper 0): 16 or 32KByte PRG, 8KByte CHR, no registers
+
+static void nrom_reset(cartridge_t *ptCartridge)
+{
+    mapper_set_prg_32k(ptCartridge, 0);                                         //!< 16KByte are mirrored
+    mapper_set_chr_8k(ptCartridge, 0);
+}
+
+const mapper_t mapper_nrom = {
+    .hwNumber   = 0,
+    .pchName    = "NROM",
+    .fnReset    = nrom_reset,
+    .fnWrite    = NULL,
+};
@@ -0,0 +1,24 @@
+#include "mapper.h"
+#include "cartridge.h"
+
+//! \brief UxROM (mapper 2): switchable 16KByte at 0x8000, last bank fixed at 0xC000
+
+static void uxrom_reset(cartridge_t *ptCartridge)
+{
+    mapper_set_prg_16k(ptCartridge, 0, 0);
+    mapper_set_prg_16k(ptCartridge, 1, (ptCartridge->wPRGSize >> 14) - 1);
+    mapper_set_chr_8k(ptCartridge, 0);
+}
+
+static void uxrom_write(cartridge_t *ptCartridge, uint_fast16_t hwAddress, uint_fast8_t chData)
+{
+    chData = mapper_bus_conflict(ptCartridge, hwAddress, chData);
+    mapper_set_prg_16k(ptCartridge, 0, chData);
+}
+
+const mapper_t mapper_uxrom = {
+    .hwNumber   = 2,
+    .pchName    = "UxROM",
+    .fnReset    = uxrom_reset,
+    .fnWrite    = uxrom_write,
+};
@@ -0,0 +1,249 @@
+#include <stddef.h>
+#include <string.h>
+#ifndef _WIN32
+#   include <pthread.h>
+#endif
+#include "console.h"
+#include "jeg_cfg.h"
+
+#define CONSOLE_MAX_THREADS             64
+
+#define LAYOUT(__NAME, __MEMBER)    {__NAME, offsetof(console_t, __MEMBER), sizeof(((console_t *)0)->__MEMBER)}
+
+const console_layout_t console_layout[] = {
+    LAYOUT("cpu",               tNES.cpu),
+    LAYOUT("ram",               tNES.ram_data),
+    LAYOUT("nes",               tNES),
+    LAYOUT("cartridge",         tCartridge),
+    LAYOUT("controller",        tController),
+    LAYOUT("ppu framebuffer",   tPPU.tFramebuffer),
+    LAYOUT("ppu caching",       tPPU.tCaching),
+    LAYOUT("frame",             chFrame),
+    {"console", 0, offsetof(console_t, chRAM)},                                 //!< without the cartridge RAM
+};
+
+const uint_fast8_t console_layout_size = UBOUND(console_layout);
+
+uint_fast32_t console_size(const uint8_t *pchROM, uint_fast32_t wSize)
+{
+    uint_fast32_t wRAMSize = cartridge_ram_size(pchROM, wSize);
+
+    if (0 == wRAMSize) {
+        return 0;
+    }
+    return  (offsetof(console_t, chRAM) + wRAMSize + JEG_CACHE_LINE_SIZE - 1)
+        &   ~(uint_fast32_t)(JEG_CACHE_LINE_SIZE - 1);
+}
+
+cartridge_err_t console_init(console_t *ptConsole, uint_fast32_t wBlockSize, ppu_backend_t tBackend,
+                             const uint8_t *pchROM, uint_fast32_t wSize)
+{
+    cartridge_err_t tResult;
+
+    if (NULL == ptConsole) {
+        return err_illegal_pointer;
+    }
+    if (wBlockSize < offsetof(console_t, chRAM)) {
+        return err_illegal_size;
+    }
+    //! a fresh block, e.g. the controller shift registers are not set by their init
+    memset(ptConsole, 0, offsetof(console_t, chRAM));
+    if (!ppu_init(&ptConsole->tNES, &ptConsole->tPPU, tBackend, ptConsole->chFrame)) {
+        return err_illegal_parameter;
+    }
+    controller_direct_init(&ptConsole->tNES, &ptConsole->tController);
+    controller_direct_set(&ptConsole->tNES, 0, 0);
+
+    ptConsole->wBlockSize = wBlockSize;
+    tResult = cartridge_init(&ptConsole->tNES, &ptConsole->tCartridge, pchROM, wSize,
+                             ptConsole->chRAM, wBlockSize - offsetof(console_t, chRAM));
+    if (ok != tResult) {
+        return tResult;
+    }
+    nes_init(&ptConsole->tNES);
+    return ok;
+}
+
+//! \brief move a pointer into the source block to the same place in the destination block
+static void *rebase(const void *pPointer, const console_t *ptSource, console_t *ptConsole)
+{
+    uintptr_t wPointer = (uintptr_t)pPointer;
+    uintptr_t wSource = (uintptr_t)ptSource;
+
+    if (wPointer < wSource || wPointer >= wSource + ptSource->wBlockSize) {
+        return (void *)pPointer;                                                //!< ROM, static or NULL
+    }
+    return (uint8_t *)ptConsole + (wPointer - wSource);
+}
+
+#define REBASE(__POINTER)   (__POINTER) = rebase((__POINTER), ptSource, ptConsole)
+
+cartridge_err_t console_clone(console_t *ptConsole, uint_fast32_t wBlockSize, const console_t *ptSource)
+{
+    cartridge_t *ptCartridge = &ptConsole->tCartridge;
+    uint8_t *pchFrame = NULL;
+
+    if (NULL == ptConsole || NULL == ptSource) {
+        return err_illegal_pointer;
+    }
+    if (wBlockSize < ptSource->wBlockSize) {
+        return err_illegal_size;
+    }
+
+    memcpy(ptConsole, ptSource, ptSource->wBlockSize);
+    ptConsole->wBlockSize = wBlockSize;
+
+    REBASE(ptConsole->tNES.cpu.reference);
+    REBASE(ptConsole->tNES.ppu.internal);
+    REBASE(ptConsole->tNES.cartridge.internal);
+    REBASE(ptConsole->tNES.controller.internal);
+
+    for (uint_fast8_t n = 0; n < 8; n++) {
+        REBASE(ptCartridge->pchPRGBank[n]);
+        REBASE(ptCartridge->pchCHRBank[n]);
+    }
+    for (uint_fast8_t n = 0; n < 4; n++) {
+        REBASE(ptCartridge->pchNameTable[n]);
+    }
+    REBASE(ptCartridge->pchCHRMemory);
+    REBASE(ptCartridge->pchNameTableRAM);
+    REBASE(ptCartridge->ptCPU);
+
+    if (NULL != ptCartridge->pchPRGRAM && ptCartridge->pchPRGRAM == rebase(ptCartridge->pchPRGRAM, ptSource, ptConsole)) {
+        //! attached battery RAM: take a copy into the PRG-RAM part of the block
+        uint_fast32_t wOffset = ptCartridge->pchPRGBank[3] - ptCartridge->pchPRGRAM;
+
+        memcpy(ptConsole->chRAM, ptCartridge->pchPRGRAM, ptCartridge->wPRGRAMSize);
+        ptCartridge->pchPRGRAM = ptConsole->chRAM;
+        ptCartridge->pchPRGBank[3] = ptConsole->chRAM + wOffset;
+    } else {
+        REBASE(ptCartridge->pchPRGRAM);
+    }
+
+    switch (ptConsole->tPPU.tBackend) {
+        case PPU_BACKEND_FRAMEBUFFER:
+            REBASE(ptConsole->tPPU.tFramebuffer.video_frame_data);
+            pchFrame = ptConsole->tPPU.tFramebuffer.video_frame_data;
+            break;
+        case PPU_BACKEND_CACHING:
+            REBASE(ptConsole->tPPU.tCaching.nes);
+        #if JEG_USE_EXTERNAL_DRAW_PIXEL_INTERFACE == DISABLED
+            REBASE(ptConsole->tPPU.tCaching.video_frame_data);
+            pchFrame = ptConsole->tPPU.tCaching.video_frame_data;
+        #endif
+        #if JEG_USE_BACKGROUND_BUFFERING == ENABLED
+            for (uint_fast8_t n = 0; n < UBOUND(ptConsole->tPPU.tCaching.tNameTableBuffer); n++) {
+                for (uint_fast8_t m = 0; m < 4; m++) {
+                    REBASE(ptConsole->tPPU.tCaching.tNameTableBuffer[n].pchPatternBank[m]);
+                }
+            }
+        #endif
+            break;
+        default:
+            break;
+    }
+
+    if (NULL != pchFrame && pchFrame != ptConsole->chFrame) {
+        //! a host picture buffer (see ppu_set_pixel_format()) stays with the original
+        ppu_set_pixel_format(&ptConsole->tPPU, PPU_PIXEL_INDEX, ptConsole->chFrame);
+    }
+    return ok;
+}
+
+//! \brief a slice of a batch, run by one thread
+typedef struct {
+    console_batch_func_t   *fnRun;
+    void                   *pBatch;
+    uint_fast32_t           wFirst;
+    uint_fast32_t           wCount;
+} console_slice_t;
+
+static void *console_run_slice(void *pSlice)
+{
+    console_slice_t *ptSlice = pSlice;
+
+    ptSlice->fnRun(ptSlice->pBatch, ptSlice->wFirst, ptSlice->wCount);
+    return NULL;
+}
+
+void console_run_batch(console_batch_func_t *fnRun, void *pBatch, uint_fast32_t wCount, uint_fast8_t chThreads)
+{
+    console_slice_t tSlice[CONSOLE_MAX_THREADS];
+    uint_fast32_t wFirst = 0;
+
+    if (0 == wCount) {
+        return ;
+    }
+
+#ifdef _WIN32
+    chThreads = 1;
+#endif
+    if (chThreads > CONSOLE_MAX_THREADS) {
+        chThreads = CONSOLE_MAX_THREADS;
+    }
+    if (chThreads > wCount) {
+        chThreads = wCount;
+    }
+    if (chThreads < 1) {
+        chThreads = 1;
+    }
+
+    for (uint_fast8_t n = 0; n < chThreads; n++) {
+        uint_fast32_t wSliceCount = wCount / chThreads + (n < wCount % chThreads);
+
+        tSlice[n].fnRun             = fnRun;
+        tSlice[n].pBatch            = pBatch;
+        tSlice[n].wFirst            = wFirst;
+        tSlice[n].wCount            = wSliceCount;
+        wFirst += wSliceCount;
+    }
+
+#ifndef _WIN32
+    {
+        pthread_t tThread[CONSOLE_MAX_THREADS];
+        bool bStarted[CONSOLE_MAX_THREADS];
+
+        //! the first slice is run by the calling thread
+        for (uint_fast8_t n = 1; n < chThreads; n++) {
+            bStarted[n] = (0 == pthread_create(&tThread[n], NULL, console_run_slice, &tSlice[n]));
+            if (!bStarted[n]) {
+                console_run_slice(&tSlice[n]);
+            }
+        }
+        console_run_slice(&tSlice[0]);
+        for (uint_fast8_t n = 1; n < chThreads; n++) {
+            if (bStarted[n]) {
+                pthread_join(tThread[n], NULL);
+            }
+        }
+    }
+#else
+    console_run_slice(&tSlice[0]);
+#endif
+}
+
+//! \brief the arguments of console_iterate_frames()
+typedef struct {
+    console_t * const  *pptConsole;
+    const uint8_t      *pchInput;
+} console_frames_t;
+
+static void console_iterate_slice(void *pBatch, uint_fast32_t wFirst, uint_fast32_t wCount)
+{
+    console_frames_t *ptFrames = pBatch;
+
+    for (uint_fast32_t n = wFirst; n < wFirst + wCount; n++) {
+        nes_t *ptNES = &ptFrames->pptConsole[n]->tNES;
+
+        controller_direct_set(ptNES, ptFrames->pchInput[n * 2], ptFrames->pchInput[n * 2 + 1]);
+        nes_iterate_frame(ptNES);
+    }
+}
+
+void console_iterate_frames(console_t * const *pptConsole, const uint8_t *pchInput, uint_fast32_t wCount,
+                            uint_fast8_t chThreads)
+{
+    console_frames_t tFrames = {pptConsole, pchInput};
+
+    console_run_batch(console_iterate_slice, &tFrames, wCount, chThreads);
+}
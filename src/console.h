@@ -0,0 +1,85 @@
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "nes.h"
+#include "ppu.h"
+#include "controller_direct.h"
+#include "cartridge.h"
+#include "jeg_cfg.h"
+
+/*! \note A console_t holds the complete mutable state of one console in one
+ *!       contiguous block: cpu and RAM first, then the cartridge (bank pointers),
+ *!       the controllers, the ppu, the picture and at last the cartridge RAM,
+ *!       which is sized per ROM (see console_size()). Each part starts on its own
+ *!       cache line, so many instances neither share lines nor scatter their
+ *!       state over separate allocations. Only the ROM image stays outside, it
+ *!       is read only and can be shared by all instances (see rom.h).
+ *!
+ *! \note console_clone() copies a running console into another block: a memcpy
+ *!       of the block and the pointers into it moved to the copy, pointers into
+ *!       the ROM stay shared. This makes it cheap to branch a game into many
+ *!       input variations from the same point (see console_iterate_frames()).
+ */
+
+typedef struct console_t {
+    nes_t                   tNES                JEG_ALIGNED(JEG_CACHE_LINE_SIZE);   //!< cpu, bus and RAM
+    cartridge_t             tCartridge          JEG_ALIGNED(JEG_CACHE_LINE_SIZE);
+    controller_direct_t     tController;
+    uint_fast32_t           wBlockSize;                                                 //!< as passed to console_init()
+    ppu_t                   tPPU                JEG_ALIGNED(JEG_CACHE_LINE_SIZE);
+    uint8_t                 chFrame[256 * 240]  JEG_ALIGNED(JEG_CACHE_LINE_SIZE);   //!< palette indices
+    uint8_t                 chRAM[]             JEG_ALIGNED(JEG_CACHE_LINE_SIZE);   //!< cartridge RAM (cartridge_ram_size())
+} console_t;
+
+//! \brief a part of console_t, for reports of the memory layout
+typedef struct {
+    const char     *pchName;
+    uint_fast32_t   wOffset;
+    uint_fast32_t   wSize;
+} console_layout_t;
+
+extern const console_layout_t console_layout[];
+extern const uint_fast8_t console_layout_size;
+
+//! \brief size of the block for a console running the given ROM, 0 for an invalid image
+extern uint_fast32_t console_size(const uint8_t *rom_image, uint_fast32_t size);
+
+/*! \brief initialise all parts of the console and power it up
+ *! \param block_size size of the block ptConsole points to, at least console_size();
+ *!        the block should be aligned to JEG_CACHE_LINE_SIZE
+ */
+extern cartridge_err_t console_init(console_t *ptConsole, uint_fast32_t block_size, ppu_backend_t tBackend,
+                                    const uint8_t *rom_image, uint_fast32_t size);
+
+
+/*! \brief duplicate a running console (of any state) into another block
+ *! \param block_size size of the block ptConsole points to, at least the size of ptSource
+ *! \note  battery backed RAM attached to ptSource (cartridge_attach_battery_ram()) is
+ *!        copied into the block of the clone, so clones never write the save file.
+ *!        A picture buffer of the host (ppu_set_pixel_format()) is not shared: the
+ *!        clone draws palette values into its own chFrame, which is cleared until
+ *!        its next frame. An external draw pixel interface is shared, its tag has
+ *!        to be set again.
+ */
+extern cartridge_err_t console_clone(console_t *ptConsole, uint_fast32_t block_size, const console_t *ptSource);
+
+/*! \brief run one frame on each console, every console with its own controller input,
+ *!        using up to chThreads threads (see console_run_batch())
+ *! \param pchInput two bytes (controller 1 and 2) for each console
+ */
+extern void console_iterate_frames(console_t * const *pptConsole, const uint8_t *pchInput, uint_fast32_t wCount,
+                                   uint_fast8_t chThreads);
+
+//! \brief runs the items wFirst to wFirst + wCount - 1 of a batch
+typedef void console_batch_func_t(void *pBatch, uint_fast32_t wFirst, uint_fast32_t wCount);
+
+/*! \brief split wCount items of a batch into slices of (almost) equal size and pass
+ *!        each slice to fnRun on its own thread, the calling thread runs the first one
+ *! \note  up to 64 threads (one without POSIX threads), the items must not share
+ *!        any mutable state (e.g. consoles and their clones do not)
+ */
+extern void console_run_batch(console_batch_func_t *fnRun, void *pBatch, uint_fast32_t wCount, uint_fast8_t chThreads);
+
+#endif
@@ -331,6 +331,7 @@ void cpu6502_reset(cpu6502_t *cpu) {
     SET_FLAGS(0x24); // set following status flags: UNUSED, INTERRUPT
     cpu->cycle_number = 0;
     cpu->interrupt_pending = INTERRUPT_NONE;
+    cpu->irq_cycle = CPU6502_IRQ_NEVER;
     cpu->stall_cycles = 0;
 }
 
@@ -350,6 +351,11 @@ uint_fast32_t cpu6502_run(cpu6502_t *cpu, int_fast32_t cycles_to_run)
       cpu->stall_cycles=0;
     }
 
+    // the irq line stays asserted until the source acknowledges it
+    if (cpu->interrupt_pending==INTERRUPT_NONE && !cpu->status_I && cpu->cycle_number>=cpu->irq_cycle) {
+      cpu->interrupt_pending=INTERRUPT_IRQ;
+    }
+
     // check for interrupts
     if (cpu->interrupt_pending!=INTERRUPT_NONE) {
       PUSH(cpu->reg_PC>>8); // high byte of program counter to stack
@@ -779,8 +785,8 @@ void cpu6502_trigger_interrupt(cpu6502_t *cpu, cpu6502_interrupt_enum_t interrup
       cpu->interrupt_pending=INTERRUPT_NMI;
       break;
     case INTERRUPT_IRQ:
-      if (cpu->status_I) {
-        cpu->interrupt_pending=INTERRUPT_NMI;
+      if (!cpu->status_I && cpu->interrupt_pending==INTERRUPT_NONE) {
+        cpu->interrupt_pending=INTERRUPT_IRQ;
       }
       break;
     default:
@@ -31,6 +31,8 @@ extern const opcode_tbl_entry_t opcode_tbl[];
 
 typedef enum {INTERRUPT_NONE=0, INTERRUPT_NMI, INTERRUPT_IRQ} cpu6502_interrupt_enum_t;
 
+#define CPU6502_IRQ_NEVER UINT64_MAX // irq_cycle value when the irq line is not going to be asserted
+
 typedef uint_fast16_t cpu6502_read_func_t (void *, uint_fast16_t hwAddress); // read data [16bit] from address [16bit]
 typedef void cpu6502_write_func_t (void *, uint_fast16_t hwAddress, uint_fast8_t chValue); // write data [8bit] to address [16bit]
 
@@ -61,6 +63,7 @@ typedef struct cpu6502_t {
     uint64_t cycle_number; // number of actual cycle (measured in ppu cycles)
     int_fast32_t stall_cycles; // number of stall cycles
     cpu6502_interrupt_enum_t interrupt_pending; // type of pending interrupt
+    uint64_t irq_cycle; // cycle from which on the (level triggered) irq line is asserted, known in advance
 
     // memory interface
     void *reference; // pointer to a reference, added as argument to read and write functions
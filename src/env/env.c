@@ -0,0 +1,204 @@
+#include <string.h>
+#if defined(__SSE2__)
+#   include <emmintrin.h>
+#endif
+#include "env.h"
+#include "jeg_cfg.h"
+
+//! \brief luminance (ITU-R BT.601) of the 64 colors of the ppu palette
+static const uint8_t env_luminance[64] = {
+    124,  29,  21,  65,  59,  54,  60,  52,  52,  70,  61,  52,  48,   0,   0,   0,
+    188,  99,  80, 100,  88,  78, 107, 124, 124, 108,  99, 106,  95,   0,   0,   0,
+    248, 157, 140, 144, 173, 143, 155, 177, 182, 203, 163, 189, 161, 120,   0,   0,
+    252, 212, 191, 201, 210, 192, 214, 226, 215, 224, 222, 225, 177, 229,   0,   0,
+};
+
+static const uint_fast32_t env_observation_sizes[ENV_OBSERVATION_COUNT] = {
+    [ENV_OBSERVATION_PALETTE]       = ENV_FRAME_HEIGHT * ENV_FRAME_WIDTH,
+    [ENV_OBSERVATION_GRAYSCALE]     = ENV_FRAME_HEIGHT * ENV_FRAME_WIDTH,
+    [ENV_OBSERVATION_GRAYSCALE_84]  = ENV_RESIZED_SIZE * ENV_RESIZED_SIZE,
+    [ENV_OBSERVATION_RAM]           = 0x800,
+};
+
+static void env_grayscale(const uint8_t *pchFrame, uint8_t *pchGray)
+{
+    for (uint_fast32_t n = 0; n < ENV_FRAME_HEIGHT * ENV_FRAME_WIDTH; n++) {
+        pchGray[n] = env_luminance[pchFrame[n] & 0x3F];
+    }
+}
+
+static void env_max_pool(uint8_t *pchGray, const uint8_t *pchPrevious)
+{
+    uint_fast32_t n = 0;
+
+#if defined(__SSE2__)
+    for (; n < ENV_FRAME_HEIGHT * ENV_FRAME_WIDTH; n += 16) {
+        __m128i tPixels = _mm_max_epu8( _mm_loadu_si128((const __m128i *)&pchGray[n]),
+                                        _mm_loadu_si128((const __m128i *)&pchPrevious[n]));
+        _mm_storeu_si128((__m128i *)&pchGray[n], tPixels);
+    }
+#endif
+    for (; n < ENV_FRAME_HEIGHT * ENV_FRAME_WIDTH; n++) {
+        if (pchPrevious[n] > pchGray[n]) {
+            pchGray[n] = pchPrevious[n];
+        }
+    }
+}
+
+//! \brief phwRow += hwWeight * pchLine, the weights of an output row sum up to ENV_FRAME_HEIGHT
+static void env_accumulate_line(uint16_t *phwRow, const uint8_t *pchLine, uint16_t hwWeight)
+{
+    uint_fast32_t n = 0;
+
+#if defined(__SSE2__)
+    __m128i tWeight = _mm_set1_epi16(hwWeight);
+    __m128i tZero = _mm_setzero_si128();
+
+    for (; n < ENV_FRAME_WIDTH; n += 16) {
+        __m128i tPixels = _mm_loadu_si128((const __m128i *)&pchLine[n]);
+        __m128i tLow = _mm_loadu_si128((const __m128i *)&phwRow[n]);
+        __m128i tHigh = _mm_loadu_si128((const __m128i *)&phwRow[n + 8]);
+
+        tLow = _mm_add_epi16(tLow, _mm_mullo_epi16(_mm_unpacklo_epi8(tPixels, tZero), tWeight));
+        tHigh = _mm_add_epi16(tHigh, _mm_mullo_epi16(_mm_unpackhi_epi8(tPixels, tZero), tWeight));
+        _mm_storeu_si128((__m128i *)&phwRow[n], tLow);
+        _mm_storeu_si128((__m128i *)&phwRow[n + 8], tHigh);
+    }
+#endif
+    for (; n < ENV_FRAME_WIDTH; n++) {
+        phwRow[n] += hwWeight * pchLine[n];
+    }
+}
+
+/*! \brief area resampling 256x240 -> 84x84: every output pixel is the mean of the
+ *!        source area it covers, source pixels on the border are weighted by the
+ *!        covered part. Positions are counted in 1/84 source pixels, so all weights
+ *!        are integers.
+ */
+static void env_resize(const uint8_t *pchGray, uint8_t *pchOut)
+{
+    uint16_t hwRow[ENV_FRAME_WIDTH];
+
+    for (uint_fast32_t wOutY = 0; wOutY < ENV_RESIZED_SIZE; wOutY++) {
+        uint_fast32_t wStart = wOutY * ENV_FRAME_HEIGHT;
+        uint_fast32_t wEnd = wStart + ENV_FRAME_HEIGHT;
+
+        memset(hwRow, 0, sizeof(hwRow));
+        for (uint_fast32_t y = wStart / ENV_RESIZED_SIZE; y * ENV_RESIZED_SIZE < wEnd; y++) {
+            uint_fast32_t wLow = (y * ENV_RESIZED_SIZE > wStart) ? y * ENV_RESIZED_SIZE : wStart;
+            uint_fast32_t wHigh = ((y + 1) * ENV_RESIZED_SIZE < wEnd) ? (y + 1) * ENV_RESIZED_SIZE : wEnd;
+
+            env_accumulate_line(hwRow, &pchGray[y * ENV_FRAME_WIDTH], wHigh - wLow);
+        }
+
+        for (uint_fast32_t wOutX = 0; wOutX < ENV_RESIZED_SIZE; wOutX++) {
+            uint_fast32_t wSum = 0;
+
+            wStart = wOutX * ENV_FRAME_WIDTH;
+            wEnd = wStart + ENV_FRAME_WIDTH;
+            for (uint_fast32_t x = wStart / ENV_RESIZED_SIZE; x * ENV_RESIZED_SIZE < wEnd; x++) {
+                uint_fast32_t wLow = (x * ENV_RESIZED_SIZE > wStart) ? x * ENV_RESIZED_SIZE : wStart;
+                uint_fast32_t wHigh = ((x + 1) * ENV_RESIZED_SIZE < wEnd) ? (x + 1) * ENV_RESIZED_SIZE : wEnd;
+
+                wSum += (wHigh - wLow) * hwRow[x];
+            }
+            pchOut[wOutY * ENV_RESIZED_SIZE + wOutX] =
+                (wSum + ENV_FRAME_WIDTH * ENV_FRAME_HEIGHT / 2) / (ENV_FRAME_WIDTH * ENV_FRAME_HEIGHT);
+        }
+    }
+}
+
+bool env_init(env_t *ptEnv, console_t *ptConsole, env_observation_t tObservation, bool bMaxPool)
+{
+    if (NULL == ptEnv || NULL == ptConsole || tObservation >= ENV_OBSERVATION_COUNT) {
+        return false;
+    }
+    ptEnv->ptConsole = ptConsole;
+    ptEnv->tObservation = tObservation;
+    ptEnv->bMaxPool = bMaxPool;
+    memset(ptEnv->chPrevious, 0, sizeof(ptEnv->chPrevious));
+    return true;
+}
+
+uint_fast32_t env_observation_size(env_observation_t tObservation)
+{
+    if (tObservation >= ENV_OBSERVATION_COUNT) {
+        return 0;
+    }
+    return env_observation_sizes[tObservation];
+}
+
+void env_step(env_t *ptEnv, uint8_t chAction, uint_fast8_t chFrameSkip, uint8_t *pchObservation)
+{
+    console_t *ptConsole = ptEnv->ptConsole;
+    bool bMaxPool =     ptEnv->bMaxPool
+                    &&  (   ENV_OBSERVATION_GRAYSCALE == ptEnv->tObservation
+                        ||  ENV_OBSERVATION_GRAYSCALE_84 == ptEnv->tObservation);
+
+    if (0 == chFrameSkip) {
+        chFrameSkip = 1;
+    }
+
+    controller_direct_set(&ptConsole->tNES, chAction, 0);
+    for (uint_fast8_t n = 0; n < chFrameSkip; n++) {
+        if (bMaxPool && n + 1 == chFrameSkip) {
+            env_grayscale(ptConsole->chFrame, ptEnv->chPrevious);
+        }
+        nes_iterate_frame(&ptConsole->tNES);
+    }
+
+    switch (ptEnv->tObservation) {
+        case ENV_OBSERVATION_PALETTE:
+            memcpy(pchObservation, ptConsole->chFrame, ENV_FRAME_HEIGHT * ENV_FRAME_WIDTH);
+            break;
+        case ENV_OBSERVATION_GRAYSCALE:
+            env_grayscale(ptConsole->chFrame, pchObservation);
+            if (bMaxPool) {
+                env_max_pool(pchObservation, ptEnv->chPrevious);
+            }
+            break;
+        case ENV_OBSERVATION_GRAYSCALE_84:
+            env_grayscale(ptConsole->chFrame, ptEnv->chGray);
+            if (bMaxPool) {
+                env_max_pool(ptEnv->chGray, ptEnv->chPrevious);
+            }
+            env_resize(ptEnv->chGray, pchObservation);
+            break;
+        case ENV_OBSERVATION_RAM:
+            memcpy(pchObservation, ptConsole->tNES.ram_data, sizeof(ptConsole->tNES.ram_data));
+            break;
+        default:
+            break;
+    }
+}
+
+//! \brief the arguments of env_step_batch()
+typedef struct {
+    env_t * const  *pptEnv;
+    const uint8_t  *pchAction;
+    uint8_t        *pchObservation;
+    uint_fast32_t   wStride;
+    uint_fast8_t    chFrameSkip;
+} env_batch_t;
+
+static void env_step_slice(void *pBatch, uint_fast32_t wFirst, uint_fast32_t wCount)
+{
+    env_batch_t *ptBatch = pBatch;
+
+    for (uint_fast32_t n = wFirst; n < wFirst + wCount; n++) {
+        env_step(   ptBatch->pptEnv[n], ptBatch->pchAction[n], ptBatch->chFrameSkip,
+                    &ptBatch->pchObservation[n * ptBatch->wStride]);
+    }
+}
+
+void env_step_batch(env_t * const *pptEnv, const uint8_t *pchAction, uint_fast8_t chFrameSkip,
+                    uint8_t *pchObservation, uint_fast32_t wCount, uint_fast8_t chThreads)
+{
+    env_batch_t tBatch = {pptEnv, pchAction, pchObservation, 0, chFrameSkip};
+
+    if (0 == wCount) {
+        return ;
+    }
+    tBatch.wStride = env_observation_size(pptEnv[0]->tObservation);
+    console_run_batch(env_step_slice, &tBatch, wCount, chThreads);
+}
@@ -0,0 +1,56 @@
+#ifndef ENV_H
+#define ENV_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "console.h"
+#include "jeg_cfg.h"
+
+/*! \note A reinforcement learning style wrapper around a console: env_step()
+ *!       holds an action (the buttons of controller 1) for a number of frames
+ *!       and writes an observation of the resulting state. Grayscale
+ *!       observations may be max-pooled over the last two frames, to remove
+ *!       the flicker of sprites drawn on every second frame only.
+ *!       env_step_batch() steps many environments, spread over threads.
+ */
+
+#define ENV_FRAME_WIDTH                 256
+#define ENV_FRAME_HEIGHT                240
+#define ENV_RESIZED_SIZE                84
+
+typedef enum {
+    ENV_OBSERVATION_PALETTE         = 0,                                        //!< 256x240 color indices (0-63), not max-pooled
+    ENV_OBSERVATION_GRAYSCALE,                                                  //!< 256x240 luminance
+    ENV_OBSERVATION_GRAYSCALE_84,                                               //!< 84x84 luminance, area resampled
+    ENV_OBSERVATION_RAM,                                                        //!< the 2KByte cpu RAM
+    ENV_OBSERVATION_COUNT,
+} env_observation_t;
+
+typedef struct {
+    console_t          *ptConsole;
+    env_observation_t   tObservation;
+    bool                bMaxPool;
+    uint8_t             chPrevious[ENV_FRAME_HEIGHT * ENV_FRAME_WIDTH];         //!< luminance of the frame before the last one
+    uint8_t             chGray[ENV_FRAME_HEIGHT * ENV_FRAME_WIDTH];             //!< full size luminance before resampling
+} env_t;
+
+//! \brief wrap an initialised console, returns false for an unknown observation
+extern bool env_init(env_t *ptEnv, console_t *ptConsole, env_observation_t tObservation, bool bMaxPool);
+
+//! \brief size of an observation in bytes, 0 for an unknown observation
+extern uint_fast32_t env_observation_size(env_observation_t tObservation);
+
+/*! \brief run chFrameSkip frames (at least one) with the buttons chAction pressed on
+ *!        controller 1 and write the observation of the last frame to pchObservation
+ */
+extern void env_step(env_t *ptEnv, uint8_t chAction, uint_fast8_t chFrameSkip, uint8_t *pchObservation);
+
+/*! \brief env_step() for wCount environments using up to chThreads threads (console_run_batch())
+ *! \param pchAction one action per environment
+ *! \param pchObservation the observations one after another, all environments need the
+ *!        same kind of observation
+ */
+extern void env_step_batch(env_t * const *pptEnv, const uint8_t *pchAction, uint_fast8_t chFrameSkip,
+                           uint8_t *pchObservation, uint_fast32_t wCount, uint_fast8_t chThreads);
+
+#endif
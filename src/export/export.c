@@ -0,0 +1,246 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#   define _GNU_SOURCE                                                          //!< memfd_create()
+#endif
+#include <stdio.h>
+#include <string.h>
+#ifndef _WIN32
+#   include <fcntl.h>
+#   include <unistd.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#endif
+#include "export.h"
+#include "jeg_cfg.h"
+
+#define EXPORT_SLOT_SIZE        (   (sizeof(export_slot_t) + EXPORT_FRAME_SIZE + EXPORT_RAM_SIZE    \
+                                    +   JEG_CACHE_LINE_SIZE - 1)                                    \
+                                &   ~(JEG_CACHE_LINE_SIZE - 1))
+
+//! \brief orders the accesses of the sequence lock (compiler and cpu)
+#if defined(__GNUC__) || defined(__clang__)
+#   define EXPORT_FENCE()       __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#else
+#   define EXPORT_FENCE()
+#endif
+
+static export_slot_t *get_slot(const export_t *ptExport, uint_fast32_t wSlot)
+{
+    const export_header_t *ptHeader = (const export_header_t *)ptExport->pchBase;
+
+    return (export_slot_t *)(ptExport->pchBase + sizeof(export_header_t) + wSlot * ptHeader->wSlotSize);
+}
+
+#ifndef _WIN32
+static export_err_t map_segment(export_t *ptExport, int hFile, bool bWriter)
+{
+    struct stat tStat;
+    const export_header_t *ptHeader;
+    void *pMapping;
+
+    if (0 != fstat(hFile, &tStat) || (uint_fast32_t)tStat.st_size < sizeof(export_header_t)) {
+        return export_err_invalid_segment;
+    }
+    pMapping = mmap(NULL, tStat.st_size, bWriter ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, hFile, 0);
+    if (MAP_FAILED == pMapping) {
+        return export_err_io;
+    }
+    ptExport->pchBase = pMapping;
+    ptExport->wSize = tStat.st_size;
+    ptExport->bWriter = bWriter;
+
+    ptHeader = pMapping;
+    if (    !bWriter
+        &&  (   0 != memcmp(ptHeader->chSignature, EXPORT_SIGNATURE, 4)
+            ||  EXPORT_VERSION != ptHeader->wVersion
+            ||  sizeof(export_header_t) + (uint_fast64_t)ptHeader->wSlots * ptHeader->wSlotSize > ptExport->wSize)) {
+        munmap(pMapping, tStat.st_size);
+        ptExport->pchBase = NULL;
+        return export_err_invalid_segment;
+    }
+    return export_ok;
+}
+#endif
+
+export_err_t export_create(export_t *ptExport, const char *pchName, uint_fast32_t wSlots)
+{
+#ifndef _WIN32
+    export_header_t *ptHeader;
+    export_err_t tResult;
+    uint_fast32_t wSize = sizeof(export_header_t) + wSlots * EXPORT_SLOT_SIZE;
+    int hFile;
+
+    if (NULL == ptExport) {
+        return export_err_illegal_pointer;
+    }
+    memset(ptExport, 0, sizeof(export_t));
+    ptExport->hFile = -1;
+
+    if (NULL != pchName) {
+        if (strlen(pchName) >= sizeof(ptExport->chName)) {
+            return export_err_illegal_pointer;
+        }
+        hFile = shm_open(pchName, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    } else {
+    #ifdef __linux__
+        hFile = memfd_create("jeg-export", 0);
+    #else
+        return export_err_unsupported;
+    #endif
+    }
+    if (hFile < 0) {
+        return export_err_io;
+    }
+    if (0 != ftruncate(hFile, wSize)) {                                         //!< a new segment is zeroed
+        close(hFile);
+        return export_err_io;
+    }
+
+    tResult = map_segment(ptExport, hFile, true);
+    if (export_ok != tResult) {
+        close(hFile);
+        return tResult;
+    }
+    if (NULL != pchName) {
+        close(hFile);                                                           //!< the mapping stays valid
+        strcpy(ptExport->chName, pchName);
+    } else {
+        ptExport->hFile = hFile;
+    }
+
+    ptHeader = (export_header_t *)ptExport->pchBase;
+    ptHeader->wSlots = wSlots;
+    ptHeader->wSlotSize = EXPORT_SLOT_SIZE;
+    ptHeader->wFrameOffset = sizeof(export_slot_t);
+    ptHeader->wRAMOffset = sizeof(export_slot_t) + EXPORT_FRAME_SIZE;
+    ptHeader->wVersion = EXPORT_VERSION;
+    EXPORT_FENCE();
+    memcpy(ptHeader->chSignature, EXPORT_SIGNATURE, 4);                         //!< the segment is valid from now on
+    return export_ok;
+#else
+    return export_err_unsupported;
+#endif
+}
+
+export_err_t export_open(export_t *ptExport, const char *pchName)
+{
+#ifndef _WIN32
+    export_err_t tResult;
+    int hFile;
+
+    if (NULL == ptExport || NULL == pchName) {
+        return export_err_illegal_pointer;
+    }
+    memset(ptExport, 0, sizeof(export_t));
+    ptExport->hFile = -1;
+
+    hFile = shm_open(pchName, O_RDONLY, 0);
+    if (hFile < 0) {
+        return export_err_io;
+    }
+    tResult = map_segment(ptExport, hFile, false);
+    close(hFile);
+    return tResult;
+#else
+    return export_err_unsupported;
+#endif
+}
+
+export_err_t export_open_fd(export_t *ptExport, int hFile)
+{
+#ifndef _WIN32
+    if (NULL == ptExport) {
+        return export_err_illegal_pointer;
+    }
+    memset(ptExport, 0, sizeof(export_t));
+    ptExport->hFile = -1;
+    return map_segment(ptExport, hFile, false);
+#else
+    return export_err_unsupported;
+#endif
+}
+
+int export_fd(const export_t *ptExport)
+{
+    return ptExport->hFile;
+}
+
+uint_fast32_t export_slots(const export_t *ptExport)
+{
+    return ((const export_header_t *)ptExport->pchBase)->wSlots;
+}
+
+void export_publish(export_t *ptExport, uint_fast32_t wSlot, const uint8_t *pchFrame, const uint8_t *pchRAM)
+{
+    const export_header_t *ptHeader = (const export_header_t *)ptExport->pchBase;
+    export_slot_t *ptSlot;
+    uint8_t *pchSlot;
+
+    if (!ptExport->bWriter || wSlot >= ptHeader->wSlots) {
+        return ;
+    }
+    ptSlot = get_slot(ptExport, wSlot);
+    pchSlot = (uint8_t *)ptSlot;
+
+    ptSlot->wSequence++;
+    EXPORT_FENCE();
+    memcpy(pchSlot + ptHeader->wFrameOffset, pchFrame, EXPORT_FRAME_SIZE);
+    memcpy(pchSlot + ptHeader->wRAMOffset, pchRAM, EXPORT_RAM_SIZE);
+    ptSlot->dwFrame++;
+    EXPORT_FENCE();
+    ptSlot->wSequence++;
+}
+
+bool export_read(const export_t *ptExport, uint_fast32_t wSlot, uint8_t *pchFrame, uint8_t *pchRAM,
+                 uint64_t *pdwFrame)
+{
+    const export_header_t *ptHeader = (const export_header_t *)ptExport->pchBase;
+    const export_slot_t *ptSlot;
+    const uint8_t *pchSlot;
+    uint_fast32_t wSequence;
+    uint64_t dwFrame;
+
+    if (wSlot >= ptHeader->wSlots) {
+        return false;
+    }
+    ptSlot = get_slot(ptExport, wSlot);
+    pchSlot = (const uint8_t *)ptSlot;
+
+    do {
+        do {
+            wSequence = ptSlot->wSequence;
+        } while (wSequence & 0x01);
+        EXPORT_FENCE();
+
+        dwFrame = ptSlot->dwFrame;
+        if (NULL != pchFrame) {
+            memcpy(pchFrame, pchSlot + ptHeader->wFrameOffset, EXPORT_FRAME_SIZE);
+        }
+        if (NULL != pchRAM) {
+            memcpy(pchRAM, pchSlot + ptHeader->wRAMOffset, EXPORT_RAM_SIZE);
+        }
+        EXPORT_FENCE();
+    } while (wSequence != ptSlot->wSequence);
+
+    if (NULL != pdwFrame) {
+        *pdwFrame = dwFrame;
+    }
+    return 0 != dwFrame;
+}
+
+void export_close(export_t *ptExport)
+{
+    if (NULL == ptExport || NULL == ptExport->pchBase) {
+        return ;
+    }
+#ifndef _WIN32
+    munmap(ptExport->pchBase, ptExport->wSize);
+    if (ptExport->bWriter && '\0' != ptExport->chName[0]) {
+        shm_unlink(ptExport->chName);
+    }
+    if (ptExport->hFile >= 0) {
+        close(ptExport->hFile);
+    }
+#endif
+    memset(ptExport, 0, sizeof(export_t));
+    ptExport->hFile = -1;
+}
@@ -0,0 +1,97 @@
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "jeg_cfg.h"
+
+/*! \note The export places the picture and the cpu RAM of one or many consoles
+ *!       in a shared memory segment (POSIX shared memory or, without a name, a
+ *!       memfd which is handed to child processes). Other processes map the
+ *!       segment and read the frames in place, without any copies or calls
+ *!       into the emulator. Each console writes to its own slot.
+ *!
+ *! \note segment layout (native byte order, all offsets from the segment start)
+ *!
+ *!     offset          size        content
+ *!     0               64          export_header_t
+ *!     64 + n*slot     slot        slot n: export_slot_t (64 bytes), picture
+ *!                                 (256x240 color indices), cpu RAM (2KByte)
+ *!
+ *!       A slot is guarded by a sequence lock: wSequence is odd while the slot
+ *!       is written. A reader copies (or processes) the slot and accepts the
+ *!       data if wSequence was even and did not change meanwhile (see
+ *!       export_read()). dwFrame counts the frames published to the slot.
+ */
+
+#define EXPORT_SIGNATURE                "JEX\x1A"
+#define EXPORT_VERSION                  1
+#define EXPORT_FRAME_SIZE               (256 * 240)
+#define EXPORT_RAM_SIZE                 0x800
+
+typedef enum {
+    export_err_unsupported      = -5,
+    export_err_invalid_segment  = -4,
+    export_err_out_of_memory    = -3,
+    export_err_io               = -2,
+    export_err_illegal_pointer  = -1,
+    export_ok                   = 0,
+} export_err_t;
+
+typedef struct {
+    char            chSignature[4];                                             //!< EXPORT_SIGNATURE
+    uint32_t        wVersion;
+    uint32_t        wSlots;
+    uint32_t        wSlotSize;                                                  //!< distance of two slots
+    uint32_t        wFrameOffset;                                               //!< of the picture within a slot
+    uint32_t        wRAMOffset;                                                 //!< of the cpu RAM within a slot
+    uint8_t         chReserved[40];
+} export_header_t;
+
+typedef struct {
+    volatile uint32_t   wSequence;                                              //!< odd while the slot is written
+    uint32_t            wReserved;
+    volatile uint64_t   dwFrame;                                                //!< number of published frames
+    uint8_t             chReserved[48];
+} export_slot_t;
+
+typedef struct {
+    uint8_t        *pchBase;                                                    //!< the mapped segment
+    uint_fast32_t   wSize;
+    bool            bWriter;
+    int             hFile;                                                      //!< memfd of an anonymous segment, else -1
+    char            chName[64];                                                 //!< shared memory name, unlinked by the writer
+} export_t;
+
+/*! \brief create a segment with wSlots slots
+ *! \param pchName POSIX shared memory name (e.g. "/jeg"), NULL for an anonymous memfd
+ *!        (see export_fd())
+ */
+extern export_err_t export_create(export_t *ptExport, const char *pchName, uint_fast32_t wSlots);
+
+//! \brief map an existing segment read only, by its name
+extern export_err_t export_open(export_t *ptExport, const char *pchName);
+
+//! \brief map an existing segment read only, by a file descriptor (e.g. an inherited memfd)
+extern export_err_t export_open_fd(export_t *ptExport, int hFile);
+
+//! \brief file descriptor of an anonymous segment, -1 for a named one
+extern int export_fd(const export_t *ptExport);
+
+//! \brief number of slots of the segment
+extern uint_fast32_t export_slots(const export_t *ptExport);
+
+//! \brief copy a frame (picture and cpu RAM) into a slot, to be called after each frame
+extern void export_publish(export_t *ptExport, uint_fast32_t wSlot, const uint8_t *pchFrame, const uint8_t *pchRAM);
+
+/*! \brief take a consistent copy of a slot (retries while the slot is written)
+ *! \param pchFrame, pchRAM destination, either may be NULL
+ *! \return false if nothing was published to the slot yet
+ */
+extern bool export_read(const export_t *ptExport, uint_fast32_t wSlot, uint8_t *pchFrame, uint8_t *pchRAM,
+                        uint64_t *pdwFrame);
+
+//! \brief unmap the segment, the writer removes a named segment
+extern void export_close(export_t *ptExport);
+
+#endif
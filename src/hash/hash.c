@@ -0,0 +1,44 @@
+#include "hash.h"
+#include "jeg_cfg.h"
+
+//! \brief crc32 look up table (reflected polynom 0xEDB88320), generated on first use
+static uint32_t crc32_table[256];
+static uint_fast8_t crc32_table_ready = 0;
+
+static void crc32_generate_table(void)
+{
+    for (uint_fast16_t n = 0; n < 256; n++) {
+        uint32_t wValue = n;
+        for (uint_fast8_t k = 0; k < 8; k++) {
+            wValue = (wValue & 1) ? (0xEDB88320 ^ (wValue >> 1)) : (wValue >> 1);
+        }
+        crc32_table[n] = wValue;
+    }
+    crc32_table_ready = 1;
+}
+
+uint32_t hash_crc32(uint32_t wCRC, const void *pData, uint_fast32_t wSize)
+{
+    const uint8_t *pchData = (const uint8_t *)pData;
+
+    if (!crc32_table_ready) {
+        crc32_generate_table();
+    }
+
+    wCRC = ~wCRC;
+    while (wSize--) {
+        wCRC = crc32_table[(wCRC ^ *pchData++) & 0xFF] ^ (wCRC >> 8);
+    }
+    return ~wCRC;
+}
+
+uint64_t hash_fnv1a64(uint64_t dwHash, const void *pData, uint_fast32_t wSize)
+{
+    const uint8_t *pchData = (const uint8_t *)pData;
+
+    while (wSize--) {
+        dwHash ^= *pchData++;
+        dwHash *= 0x100000001B3ull;
+    }
+    return dwHash;
+}
@@ -0,0 +1,19 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <stdint.h>
+#include "jeg_cfg.h"
+
+//! \brief start value for a new crc32 calculation
+#define HASH_CRC32_INIT         0
+
+//! \brief start value (offset basis) for a new 64bit FNV-1a calculation
+#define HASH_FNV1A64_INIT       0xCBF29CE484222325ull
+
+//! \brief continue a crc32 (IEEE 802.3, as used by zip and the NES ROM databases)
+extern uint32_t hash_crc32(uint32_t wCRC, const void *pData, uint_fast32_t wSize);
+
+//! \brief continue a 64bit FNV-1a hash over the given data
+extern uint64_t hash_fnv1a64(uint64_t dwHash, const void *pData, uint_fast32_t wSize);
+
+#endif
@@ -0,0 +1,8 @@
+# JEG sources and include paths, relative to NES_SRC_PATH
+# (included by the platform and test Makefiles)
+
+INCLUDE_PATHS_NES=cartridge cpu ppu controller movie hash rom save env export .
+SRCS_NES=cartridge/cartridge.c cartridge/cartridge_db.c cartridge/mapper.c cartridge/mapper_nrom.c cartridge/mapper_mmc1.c cartridge/mapper_uxrom.c cartridge/mapper_cnrom.c cartridge/mapper_axrom.c cartridge/mapper_mmc3.c cpu/cpu6502.c ppu/ppu.c ppu/ppu_framebuffer.c ppu/ppu_caching.c ppu/ppu_tile_decode.c ppu/ppu_pixel.c ppu/ppu_sprite.c nes.c console.c controller/controller_direct.c movie/movie.c hash/hash.c rom/rom.c save/save.c env/env.c export/export.c
+
+# libraries needed by the sources (threads of console_run_batch(), add -lrt for shm_open() with glibc < 2.34)
+LIBS_NES=-pthread
@@ -16,6 +16,27 @@
 #   define UBOUND(__ARRAY)      (sizeof(__ARRAY)/sizeof(__ARRAY[0]))
 #endif
 
+//! \brief size of a cache line, the parts of console_t (console.h) are aligned to it
+#ifndef JEG_CACHE_LINE_SIZE
+#   define JEG_CACHE_LINE_SIZE  64
+#endif
+
+#ifndef JEG_ALIGNED
+#   if defined(__GNUC__) || defined(__clang__)
+#       define JEG_ALIGNED(__N) __attribute__((aligned(__N)))
+#   else
+#       define JEG_ALIGNED(__N)
+#   endif
+#endif
+
+#ifndef JEG_ALWAYS_INLINE
+#   if defined(__GNUC__) || defined(__clang__)
+#       define JEG_ALWAYS_INLINE    inline __attribute__((always_inline))
+#   else
+#       define JEG_ALWAYS_INLINE    inline
+#   endif
+#endif
+
 
 
 /*----------------------------------------------------------------------------*
@@ -38,7 +59,26 @@
 #   define JEG_USE_DUMMY_READS                         DISABLED
 #endif
 
-/*! \brief This switch is used to enable optimized sprite processing
+/*! \brief This switch is used to copy the source page of an OAM DMA ($4014)
+ *!        directly from memory (RAM or cartridge) instead of issuing 256 single
+ *!        reads on the cpu bus. Pages containing I/O registers always use the
+ *!        single reads.
+ */
+#ifndef JEG_USE_DMA_MEMORY_COPY_ACCELERATION
+#   define JEG_USE_DMA_MEMORY_COPY_ACCELERATION        ENABLED
+#endif
+
+/*! \brief This switch is used to correct the header of known ROMs with the
+ *!        built-in ROM database. It costs a crc32 over PRG- and CHR-ROM for each
+ *!        ROM with an iNES (not NES 2.0) header when a cartridge is loaded.
+ */
+#ifndef JEG_USE_ROM_DATABASE
+#   define JEG_USE_ROM_DATABASE                        ENABLED
+#endif
+
+/*! \brief This switch is used to enable optimized sprite processing: the sprites
+ *!        of every scanline are kept in an index (ppu_sprite.h) which follows the
+ *!        OAM writes, so the sprite evaluation doesn't test all 64 sprites per line
  */
 #ifndef JEG_USE_OPTIMIZED_SPRITE_PROCESSING
 #   define JEG_USE_OPTIMIZED_SPRITE_PROCESSING         ENABLED
@@ -61,10 +101,19 @@
 #   define JEG_USE_FRAME_SYNC_UP_FLAG                   ENABLED
 #endif
 
-/*! \brief This switch is used to enable the support for four physical name/attribute
- *!        tables. Although it is rare, it's safe to enable it to avoid buffer overflow
- *!        caused by wrong mirroring (buffer overflow). Disable this feature could
- *!        save 2KByte memories.
+/*! \brief This switch is used to decode tile rows (two bitplane bytes to 8
+ *!        pixels) with a 1KByte look up table. When it is disabled, a few shift
+ *!        and mask operations are used instead, which suits MCUs with little
+ *!        memory or slow flash. With BMI2 (PDEP) available, neither is used.
+ */
+#ifndef JEG_USE_TILE_DECODE_LUT
+#   define JEG_USE_TILE_DECODE_LUT                      ENABLED
+#endif
+
+/*! \brief This switch is used to give all four physical name/attribute tables of a
+ *!        four screen board a background buffer (caching ppu). Without it, the
+ *!        upper two tables are decoded tile by tile, which is slower but still
+ *!        correct. Disable this feature could save about 62KByte memories.
  */
 #ifndef JEG_USE_4_PHYSICAL_NAME_ATTRIBUTE_TABLES
 #   define JEG_USE_4_PHYSICAL_NAME_ATTRIBUTE_TABLES     DISABLED
@@ -76,6 +125,9 @@
 
 /*! \brief This switch is used to add a background buffer for each name table,
  *!        so you don't need to re-draw the background every time
+ *! \note  Tiles are re-drawn on name/attribute table writes, on CHR writes to
+ *!        a tile they show and, completely, on a switch of the background
+ *!        pattern table. It costs about 32KByte per name table.
  */
 #ifndef JEG_USE_BACKGROUND_BUFFERING
 #   define  JEG_USE_BACKGROUND_BUFFERING                ENABLED
@@ -88,6 +140,15 @@
 #   define  JEG_USE_SPRITE_BUFFER                       DISABLED
 #endif
 
+/*! \brief This switch is used to draw the visible part of a scanline with a
+ *!        renderer made for the current PPUMASK (background, sprites, left
+ *!        column clipping), selected on writes to $2001. The per dot path is
+ *!        still used when an update starts or ends within the line.
+ */
+#ifndef JEG_USE_SCANLINE_RENDERERS
+#   define  JEG_USE_SCANLINE_RENDERERS                  ENABLED
+#endif
+
 /*----------------------------------------------------------------------------*
  * JEG Debug  Switches                                                        *
  *----------------------------------------------------------------------------*/
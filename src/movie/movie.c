@@ -0,0 +1,157 @@
+#include <string.h>
+#include "movie.h"
+#include "hash.h"
+#include "nes.h"
+#include "jeg_cfg.h"
+
+static const uint8_t movie_signature[4] = {'J', 'M', 'V', 0x1A};
+
+static void put_u16(uint8_t *pchBuffer, uint_fast16_t hwValue)
+{
+    pchBuffer[0] = hwValue & 0xFF;
+    pchBuffer[1] = (hwValue >> 8) & 0xFF;
+}
+
+static void put_u32(uint8_t *pchBuffer, uint_fast32_t wValue)
+{
+    put_u16(pchBuffer, wValue & 0xFFFF);
+    put_u16(pchBuffer + 2, (wValue >> 16) & 0xFFFF);
+}
+
+static uint_fast16_t get_u16(const uint8_t *pchBuffer)
+{
+    return pchBuffer[0] | (pchBuffer[1] << 8);
+}
+
+static uint_fast32_t get_u32(const uint8_t *pchBuffer)
+{
+    return get_u16(pchBuffer) | ((uint_fast32_t)get_u16(pchBuffer + 2) << 16);
+}
+
+static movie_err_t write_header(movie_t *ptMovie)
+{
+    uint8_t chHeader[MOVIE_HEADER_SIZE];
+
+    memset(chHeader, 0, sizeof(chHeader));
+    memcpy(chHeader, movie_signature, 4);
+    put_u16(&chHeader[4], ptMovie->tHeader.hwFormatVersion);
+    put_u32(&chHeader[8], ptMovie->tHeader.wEmulatorVersion);
+    put_u32(&chHeader[12], ptMovie->tHeader.wROMHash);
+    put_u32(&chHeader[16], ptMovie->tHeader.wFrameCount);
+
+    if (fwrite(chHeader, 1, sizeof(chHeader), ptMovie->ptFile) != sizeof(chHeader)) {
+        return movie_err_io;
+    }
+    return movie_ok;
+}
+
+uint_fast32_t movie_rom_hash(const uint8_t *pchROM, uint_fast32_t wSize)
+{
+    return hash_crc32(HASH_CRC32_INIT, pchROM, wSize);
+}
+
+movie_err_t movie_record_start(movie_t *ptMovie, const char *pchPath, const uint8_t *pchROM, uint_fast32_t wSize)
+{
+    if (NULL == ptMovie || NULL == pchPath || NULL == pchROM) {
+        return movie_err_illegal_pointer;
+    }
+
+    ptMovie->ptFile = fopen(pchPath, "wb");
+    if (NULL == ptMovie->ptFile) {
+        return movie_err_io;
+    }
+
+    ptMovie->tHeader.hwFormatVersion    = MOVIE_FORMAT_VERSION;
+    ptMovie->tHeader.wEmulatorVersion   = JEG_VERSION;
+    ptMovie->tHeader.wROMHash           = movie_rom_hash(pchROM, wSize);
+    ptMovie->tHeader.wFrameCount        = MOVIE_FRAME_COUNT_UNKNOWN;            //!< patched by movie_close()
+    ptMovie->wFrame                     = 0;
+    ptMovie->bRecording                 = true;
+
+    return write_header(ptMovie);
+}
+
+movie_err_t movie_record_frame(movie_t *ptMovie, uint8_t chController1, uint8_t chController2)
+{
+    uint8_t chFrame[2] = {chController1, chController2};
+
+    if (fwrite(chFrame, 1, 2, ptMovie->ptFile) != 2) {
+        return movie_err_io;
+    }
+    ptMovie->wFrame++;
+    return movie_ok;
+}
+
+movie_err_t movie_play_start(movie_t *ptMovie, const char *pchPath, const uint8_t *pchROM, uint_fast32_t wSize)
+{
+    uint8_t chHeader[MOVIE_HEADER_SIZE];
+
+    if (NULL == ptMovie || NULL == pchPath || NULL == pchROM) {
+        return movie_err_illegal_pointer;
+    }
+
+    ptMovie->wFrame     = 0;
+    ptMovie->bRecording = false;
+    ptMovie->ptFile     = fopen(pchPath, "rb");
+    if (NULL == ptMovie->ptFile) {
+        return movie_err_io;
+    }
+
+    if (    fread(chHeader, 1, sizeof(chHeader), ptMovie->ptFile) != sizeof(chHeader)
+        ||  memcmp(chHeader, movie_signature, 4)) {
+        movie_close(ptMovie);
+        return movie_err_invalid_movie;
+    }
+
+    ptMovie->tHeader.hwFormatVersion    = get_u16(&chHeader[4]);
+    ptMovie->tHeader.wEmulatorVersion   = get_u32(&chHeader[8]);
+    ptMovie->tHeader.wROMHash           = get_u32(&chHeader[12]);
+    ptMovie->tHeader.wFrameCount        = get_u32(&chHeader[16]);
+
+    if (ptMovie->tHeader.hwFormatVersion != MOVIE_FORMAT_VERSION) {
+        movie_close(ptMovie);
+        return movie_err_unsupported;
+    }
+
+    //! a different emulator version is fine (that's what movies are for), a different ROM is not
+    if (ptMovie->tHeader.wROMHash != movie_rom_hash(pchROM, wSize)) {
+        movie_close(ptMovie);
+        return movie_err_rom_mismatch;
+    }
+
+    return movie_ok;
+}
+
+bool movie_play_frame(movie_t *ptMovie, uint8_t *pchController1, uint8_t *pchController2)
+{
+    uint8_t chFrame[2];
+
+    if (ptMovie->wFrame >= ptMovie->tHeader.wFrameCount) {
+        return false;
+    }
+    if (fread(chFrame, 1, 2, ptMovie->ptFile) != 2) {
+        return false;
+    }
+
+    *pchController1 = chFrame[0];
+    *pchController2 = chFrame[1];
+    ptMovie->wFrame++;
+    return true;
+}
+
+void movie_close(movie_t *ptMovie)
+{
+    if (NULL == ptMovie->ptFile) {
+        return;
+    }
+
+    if (ptMovie->bRecording) {
+        ptMovie->tHeader.wFrameCount = ptMovie->wFrame;
+        if (0 == fseek(ptMovie->ptFile, 0, SEEK_SET)) {
+            write_header(ptMovie);
+        }
+    }
+
+    fclose(ptMovie->ptFile);
+    ptMovie->ptFile = NULL;
+}
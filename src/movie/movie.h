@@ -0,0 +1,70 @@
+#ifndef MOVIE_H
+#define MOVIE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "jeg_cfg.h"
+
+/*! \note movie file layout (all values little endian)
+ *!
+ *!     offset  size    content
+ *!     0       4       signature "JMV\x1A"
+ *!     4       2       movie format version (MOVIE_FORMAT_VERSION)
+ *!     6       2       reserved (0)
+ *!     8       4       emulator version (JEG_VERSION) used for recording
+ *!     12      4       crc32 of the complete ROM image
+ *!     16      4       number of frames (0xFFFFFFFF: unknown, read until end of file)
+ *!     20      12      reserved (0)
+ *!     32      2*n     per frame: controller 1, controller 2
+ *!
+ *!     The movie starts at power up, i.e. directly after cartridge_init() and
+ *!     nes_init(). Each frame is one nes_iterate_frame() call.
+ */
+
+#define MOVIE_FORMAT_VERSION                1
+#define MOVIE_HEADER_SIZE                   32
+#define MOVIE_FRAME_COUNT_UNKNOWN           0xFFFFFFFF
+
+typedef enum {
+    movie_err_io                = -5,
+    movie_err_rom_mismatch      = -4,
+    movie_err_unsupported       = -3,
+    movie_err_invalid_movie     = -2,
+    movie_err_illegal_pointer   = -1,
+    movie_ok                    = 0,
+} movie_err_t;
+
+typedef struct {
+    uint_fast16_t   hwFormatVersion;
+    uint_fast32_t   wEmulatorVersion;
+    uint_fast32_t   wROMHash;                                                   //!< crc32 over the whole ROM image
+    uint_fast32_t   wFrameCount;
+} movie_header_t;
+
+typedef struct {
+    FILE           *ptFile;
+    movie_header_t  tHeader;
+    uint_fast32_t   wFrame;                                                     //!< number of frames recorded or played
+    bool            bRecording;
+} movie_t;
+
+//! \brief crc32 of a ROM image, as stored in the movie header
+extern uint_fast32_t movie_rom_hash(const uint8_t *pchROM, uint_fast32_t wSize);
+
+//! \brief create a new movie file for the given ROM image
+extern movie_err_t movie_record_start(movie_t *ptMovie, const char *pchPath, const uint8_t *pchROM, uint_fast32_t wSize);
+
+//! \brief append the controller state of one frame
+extern movie_err_t movie_record_frame(movie_t *ptMovie, uint8_t chController1, uint8_t chController2);
+
+//! \brief open a movie file and check it against the given ROM image
+extern movie_err_t movie_play_start(movie_t *ptMovie, const char *pchPath, const uint8_t *pchROM, uint_fast32_t wSize);
+
+//! \brief fetch the controller state of the next frame, returns false at the end of the movie
+extern bool movie_play_frame(movie_t *ptMovie, uint8_t *pchController1, uint8_t *pchController2);
+
+//! \brief finish the movie (the frame count of a recording is written to the header)
+extern void movie_close(movie_t *ptMovie);
+
+#endif
@@ -9,7 +9,13 @@ static uint_fast16_t cpu6502_bus_read (void *ref, uint_fast16_t address)
     nes_t* nes=(nes_t *)ref;
 
     if (address<0x2000) {
-        return *(uint16_t*)&nes->ram_data[address & 0x7FF];
+        uint_fast16_t hwOffset = address & 0x7FF;
+
+        if (hwOffset != 0x7FF) {
+            return *(uint16_t*)&nes->ram_data[hwOffset];
+        }
+        //! the upper byte of the 16bit access is located in the next mirror
+        return nes->ram_data[0x7FF] | (nes->ram_data[0] << 8);
         
     } else if (address>=0x6000) {
         return nes->cartridge.read_prg(nes->cartridge.internal, address);
@@ -23,6 +29,17 @@ static uint_fast16_t cpu6502_bus_read (void *ref, uint_fast16_t address)
     return 0;
 }
 
+uint8_t *nes_get_page_pointer(nes_t *nes, uint_fast8_t chPage)
+{
+    if (chPage < 0x20) {
+        return &nes->ram_data[(chPage << 8) & 0x7FF];
+
+    } else if (chPage >= 0x60 && NULL != nes->cartridge.get_prg_page) {
+        return nes->cartridge.get_prg_page(nes->cartridge.internal, chPage << 8);
+    }
+    return NULL;
+}
+
 static void cpu6502_bus_write (void *ref, uint_fast16_t address, uint_fast8_t value) 
 {
     nes_t* nes=(nes_t *)ref;
@@ -34,7 +51,20 @@ static void cpu6502_bus_write (void *ref, uint_fast16_t address, uint_fast8_t va
         nes->ppu.write(nes, address, value);
         
     } else if (address==0x4014) {
-        nes->ppu.write_dma(nes, &(nes->ram_data[value<<8]) );
+        uint8_t chBuffer[256];
+        uint8_t *pchPage = NULL;
+
+    #if JEG_USE_DMA_MEMORY_COPY_ACCELERATION == ENABLED
+        pchPage = nes_get_page_pointer(nes, value);
+    #endif
+        if (NULL == pchPage) {
+            //! slow path: the page is not plain memory (e.g. I/O registers)
+            for (uint_fast16_t n = 0; n < 256; n++) {
+                chBuffer[n] = cpu6502_bus_read(nes, (value << 8) | n) & 0xFF;
+            }
+            pchPage = chBuffer;
+        }
+        nes->ppu.write_dma(nes, pchPage);
         nes->cpu.stall_cycles += 513;
         if (nes->cpu.cycle_number & 0x01) {
             nes->cpu.stall_cycles++;
@@ -44,63 +74,26 @@ static void cpu6502_bus_write (void *ref, uint_fast16_t address, uint_fast8_t va
         nes->controller.write(nes, value);
         
     } else if (address>=0x6000) {
+        if (address>=0x8000) {
+            //! mapper registers switch CHR banks and mirroring: the ppu draws the dots up to now with the old ones
+            nes->ppu.update(nes);
+        }
         nes->cartridge.write_prg(nes->cartridge.internal, address, value);
-    } 
+    }
 }
 
-#if JEG_USE_EXTERNAL_DRAW_PIXEL_INTERFACE == ENABLED
-bool nes_init(nes_t *ptNES, nes_cfg_t *ptCFG) 
-#else
 void nes_init(nes_t *ptNES)
-#endif
-{ 
- #if JEG_USE_EXTERNAL_DRAW_PIXEL_INTERFACE == ENABLED
- bool bResult = false;
- #endif
-    do {
-    #if JEG_USE_EXTERNAL_DRAW_PIXEL_INTERFACE == ENABLED
-        
-        if (    NULL == ptNES 
-            ||  NULL == ptCFG) {
-            break;
-        } else if (NULL == ptCFG->fnDrawPixel) {
-            break;
-        }
-    #else
-        if ( NULL == ptNES ) {
-            break;
-        }
-    #endif
-
+{
     cpu6502_init(&ptNES->cpu, ptNES, &cpu6502_bus_read, &cpu6502_bus_write);
-    
-    #if JEG_USE_EXTERNAL_DRAW_PIXEL_INTERFACE == ENABLED
-        {
-            ppu_cfg_t tCFG = {
-                ptNES,
-                ppu_bus_read,
-                ppu_bus_write,
-                ptCFG->fnDrawPixel,
-                ptCFG->ptTag,
-            };
-            if (ppu_init(&ptNES->ppu, &tCFG)) {
-                break;
-            }
-        }
-        bResult = true;
-    #endif
-        
-    } while(false);
     nes_reset(ptNES);
-#if JEG_USE_EXTERNAL_DRAW_PIXEL_INTERFACE == ENABLED
-    return bResult;
-#endif
 }
 
 void nes_reset(nes_t *nes)
 {
     cpu6502_reset(&nes->cpu);
     nes->ppu.reset(nes);
+    //! rendering is disabled after the reset, the next ppumask write passes the actual position
+    nes->cartridge.ppu_setup(nes->cartridge.internal, 0, 0, 0, 0);
     memset(&nes->ram_data, 0, 0x800);
 }
 
@@ -7,6 +7,16 @@
 #include <stdint.h>
 #include "jeg_cfg.h"
 
+//! \name emulator version, stored e.g. in recorded movies
+//! @{
+#define JEG_VERSION_MAJOR       0
+#define JEG_VERSION_MINOR       1
+#define JEG_VERSION_PATCH       0
+#define JEG_VERSION             (   (JEG_VERSION_MAJOR << 16)                   \
+                                |   (JEG_VERSION_MINOR << 8)                    \
+                                |   (JEG_VERSION_PATCH))
+//! @}
+
 struct nes_t;
 
 typedef struct nes_t {
@@ -15,7 +25,7 @@ typedef struct nes_t {
   struct {
     uint_fast8_t (*read) (struct nes_t *nes, uint_fast16_t address);
     void (*write) (struct nes_t *nes, uint_fast16_t address, uint_fast8_t data);
-    void (*write_dma) (struct nes_t *nes, uint8_t *data);    
+    void (*write_dma) (struct nes_t *nes, uint8_t *data);                       //!< data: the 256 byte of the source page
     uint_fast32_t (*update) (struct nes_t *nes);
     void (*reset) (struct nes_t *nes);
     void *internal;
@@ -26,6 +36,10 @@ typedef struct nes_t {
     void (*write_prg) (cartridge_t *catridge, uint_fast16_t address, uint_fast8_t value);
     uint_fast8_t (*read_chr) (cartridge_t *catridge, uint_fast16_t address);
     void (*write_chr) (cartridge_t *catridge, uint_fast16_t address, uint_fast8_t value);
+    uint8_t *(*get_prg_page) (cartridge_t *cartridge, uint_fast16_t address);  //!< direct pointer to a 256 byte page, NULL if not memory
+    uint8_t *(*get_chr_bank) (cartridge_t *cartridge, uint_fast16_t address);  //!< direct pointer to the 1KByte pattern table bank
+    void (*ppu_setup) (cartridge_t *cartridge, uint_fast64_t cycle, uint_fast32_t dot,
+                       uint_fast8_t ppuctrl, uint_fast8_t ppumask);             //!< the ppu changed its pattern fetches (e.g. for irq counters)
     void (*reset) (struct nes_t *cartridge);
     void *internal;
   } cartridge;
@@ -44,4 +58,7 @@ extern void nes_reset(nes_t *);
 
 extern void nes_iterate_frame(nes_t *); // run cpu until next complete frame
 
+//! \brief direct pointer to the 256 byte cpu page (e.g. for OAM DMA), NULL if the page is no plain memory
+extern uint8_t *nes_get_page_pointer(nes_t *nes, uint_fast8_t chPage);
+
 #endif
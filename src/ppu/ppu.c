@@ -0,0 +1,174 @@
+#include <string.h>
+#include "ppu.h"
+#include "jeg_cfg.h"
+
+static const char *backend_names[PPU_BACKEND_COUNT] = {
+    [PPU_BACKEND_FRAMEBUFFER]   = "framebuffer",
+    [PPU_BACKEND_CACHING]       = "caching",
+};
+
+bool ppu_init(nes_t *nes, ppu_t *ppu, ppu_backend_t tBackend, uint8_t *video_frame_data)
+{
+    if (NULL == nes || NULL == ppu) {
+        return false;
+    }
+
+    ppu->tBackend = tBackend;
+    switch (tBackend) {
+        case PPU_BACKEND_FRAMEBUFFER:
+            ppu_framebuffer_init(nes, &ppu->tFramebuffer, video_frame_data);
+            break;
+        case PPU_BACKEND_CACHING:
+            ppu_caching_init(nes, &ppu->tCaching, video_frame_data);
+            break;
+        default:
+            return false;
+    }
+    return true;
+}
+
+//! \brief change tracking of the backend, NULL if it has no picture buffer
+static ppu_dirty_t *get_dirty(const ppu_t *ppu)
+{
+    switch (ppu->tBackend) {
+        case PPU_BACKEND_FRAMEBUFFER:
+            return (ppu_dirty_t *)&ppu->tFramebuffer.tDirty;
+#if JEG_USE_EXTERNAL_DRAW_PIXEL_INTERFACE == DISABLED
+        case PPU_BACKEND_CACHING:
+            return (ppu_dirty_t *)&ppu->tCaching.tDirty;
+#endif
+        default:
+            return NULL;
+    }
+}
+
+bool ppu_set_pixel_format(ppu_t *ppu, ppu_pixel_format_t tFormat, void *pFrame)
+{
+    ppu_pixel_output_t *ptOutput;
+    const uint_fast8_t *pchPalette;
+    uint_fast8_t chPPUMask;
+
+    if (NULL == pFrame || 0 == ppu_pixel_size(tFormat)) {
+        return false;
+    }
+
+    switch (ppu->tBackend) {
+        case PPU_BACKEND_FRAMEBUFFER:
+            ppu->tFramebuffer.video_frame_data = pFrame;
+            ptOutput = &ppu->tFramebuffer.tOutput;
+            pchPalette = ppu->tFramebuffer.palette;
+            chPPUMask = ppu->tFramebuffer.ppumask;
+            break;
+#if JEG_USE_EXTERNAL_DRAW_PIXEL_INTERFACE == DISABLED
+        case PPU_BACKEND_CACHING:
+            ppu->tCaching.video_frame_data = pFrame;
+            ptOutput = &ppu->tCaching.tOutput;
+            pchPalette = ppu->tCaching.palette;
+            chPPUMask = ppu->tCaching.ppumask;
+            break;
+#endif
+        default:
+            return false;
+    }
+
+    ppu_pixel_setup(ptOutput, tFormat, pchPalette, chPPUMask);
+    ppu_pixel_clear(ptOutput, pFrame);
+    memset(get_dirty(ppu), 0xFF, sizeof(ppu_dirty_t));                         //!< the host has to show the cleared picture
+    return true;
+}
+
+const uint32_t *ppu_dirty_lines(const ppu_t *ppu)
+{
+    ppu_dirty_t *ptDirty = get_dirty(ppu);
+
+    return NULL == ptDirty ? NULL : ptDirty->wLines;
+}
+
+void ppu_clear_dirty_lines(ppu_t *ppu)
+{
+    ppu_dirty_t *ptDirty = get_dirty(ppu);
+
+    if (NULL != ptDirty) {
+        memset(ptDirty, 0, sizeof(ppu_dirty_t));
+    }
+}
+
+bool ppu_frame_changed(const ppu_t *ppu)
+{
+    const uint32_t *pwDirtyLines = ppu_dirty_lines(ppu);
+    uint32_t wDirty = 0;
+
+    if (NULL == pwDirtyLines) {
+        return true;                                                            //!< unknown, so it might have changed
+    }
+    for (uint_fast8_t n = 0; n < PPU_DIRTY_LINE_WORDS; n++) {
+        wDirty |= pwDirtyLines[n];
+    }
+    return wDirty != 0;
+}
+
+uint_fast16_t ppu_push_dirty_rects(ppu_t *ppu, ppu_dirty_rect_func_t *fnRect, void *ptTag)
+{
+    ppu_dirty_t *ptDirty = get_dirty(ppu);
+    uint32_t wBlocks[UBOUND(ptDirty->wBlocks)];
+    uint_fast16_t hwCount = 0;
+
+    if (NULL == ptDirty) {
+        fnRect(ptTag, 0, 0, 256, 240);                                          //!< nothing known, so everything
+        return 1;
+    }
+    memcpy(wBlocks, ptDirty->wBlocks, sizeof(wBlocks));
+    memset(ptDirty, 0, sizeof(ppu_dirty_t));
+
+    for (uint_fast8_t chRow = 0; chRow < UBOUND(wBlocks); chRow++) {
+        uint_fast8_t chX = 0;
+
+        while (chX < 32 && wBlocks[chRow]) {
+            uint_fast8_t chEnd, chHeight = 1;
+            uint32_t wRun;
+
+            if (!((wBlocks[chRow] >> chX) & 1)) {
+                chX++;
+                continue;
+            }
+
+            //! a run of dirty blocks in this row ...
+            chEnd = chX + 1;
+            while (chEnd < 32 && ((wBlocks[chRow] >> chEnd) & 1)) {
+                chEnd++;
+            }
+            wRun = (chEnd - chX == 32 ? 0xFFFFFFFF : (((uint32_t)1 << (chEnd - chX)) - 1)) << chX;
+
+            //! ... grows downwards as long as the rows below are dirty at the same columns
+            while (chRow + chHeight < UBOUND(wBlocks) && (wBlocks[chRow + chHeight] & wRun) == wRun) {
+                wBlocks[chRow + chHeight] &= ~wRun;
+                chHeight++;
+            }
+            wBlocks[chRow] &= ~wRun;
+
+            fnRect(ptTag, chX * 8, chRow * 8, (chEnd - chX) * 8, chHeight * 8);
+            hwCount++;
+            chX = chEnd;
+        }
+    }
+    return hwCount;
+}
+
+const char *ppu_backend_name(ppu_backend_t tBackend)
+{
+    if (tBackend >= PPU_BACKEND_COUNT) {
+        return NULL;
+    }
+    return backend_names[tBackend];
+}
+
+bool ppu_backend_from_name(const char *pchName, ppu_backend_t *ptBackend)
+{
+    for (uint_fast8_t n = 0; n < PPU_BACKEND_COUNT; n++) {
+        if (0 == strcmp(pchName, backend_names[n])) {
+            *ptBackend = (ppu_backend_t)n;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,77 @@
+#ifndef PPU_H
+#define PPU_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "nes.h"
+#include "ppu_framebuffer.h"
+#include "ppu_caching.h"
+
+//! \brief available ppu implementations, selectable at runtime
+typedef enum {
+    PPU_BACKEND_FRAMEBUFFER     = 0,                                            //!< dot based reference implementation
+    PPU_BACKEND_CACHING,                                                        //!< ppu with name table and sprite caching
+    PPU_BACKEND_COUNT,
+} ppu_backend_t;
+
+//! \brief storage for any of the ppu implementations
+typedef struct {
+    ppu_backend_t           tBackend;                                           //!< the implementation in use, set by ppu_init()
+    union {
+        ppu_framebuffer_t   tFramebuffer;
+        ppu_caching_t       tCaching;
+    };
+} ppu_t;
+
+//! \brief initialise the selected ppu implementation and install it as nes->ppu, the functions below follow tBackend
+extern bool ppu_init(nes_t *nes, ppu_t *ppu, ppu_backend_t tBackend, uint8_t *video_frame_data);
+
+/*! \brief let the ppu write host pixels (e.g. ARGB8888 for a texture) instead of palette values
+ *! \param pFrame the new picture buffer of 256*240*ppu_pixel_size() bytes, it is cleared
+ *! \note  the colors follow the grayscale and emphasis bits of PPUMASK, palette values
+ *!        (PPU_PIXEL_INDEX) are stored as written to the palette RAM. console_clone()
+ *!        resets a clone to palette values in its own chFrame.
+ *! \return false for an unknown format or without a picture buffer (external draw pixel interface)
+ */
+extern bool ppu_set_pixel_format(ppu_t *ppu, ppu_pixel_format_t tFormat, void *pFrame);
+
+/*! \brief lines of the picture which changed since the last ppu_clear_dirty_lines()
+ *!        (PPU_DIRTY_LINE_WORDS words, bit n%32 of word n/32 for line n), all lines after a reset
+ *! \note  NULL if the picture is passed to an external draw pixel interface
+ */
+extern const uint32_t *ppu_dirty_lines(const ppu_t *ppu);
+
+//! \brief the host has shown the picture, start tracking changes (lines and blocks) from now on
+extern void ppu_clear_dirty_lines(ppu_t *ppu);
+
+//! \brief true if any pixel changed since the last ppu_clear_dirty_lines() (e.g. to skip duplicate frames)
+extern bool ppu_frame_changed(const ppu_t *ppu);
+
+/*! \brief receives a changed part of the picture
+ *! \param hwX, hwY, hwWidth, hwHeight the rectangle in pixels (multiples of 8)
+ */
+typedef void ppu_dirty_rect_func_t(void *ptTag, uint_fast16_t hwX, uint_fast16_t hwY,
+                                   uint_fast16_t hwWidth, uint_fast16_t hwHeight);
+
+/*! \brief pass the changed parts of the picture as rectangles to fnRect and clear the tracking
+ *!        (as ppu_clear_dirty_lines()), e.g. to update a display over a slow bus
+ *! \note  the rectangles are built from the changed 8x8 blocks: runs in a block row,
+ *!        grown downwards while the next rows are dirty at the same columns
+ *! \return number of rectangles, the whole picture is passed without tracking
+ */
+extern uint_fast16_t ppu_push_dirty_rects(ppu_t *ppu, ppu_dirty_rect_func_t *fnRect, void *ptTag);
+
+//! \brief true if line hwLine is set in a bitmap of ppu_dirty_lines()
+static inline bool ppu_line_dirty(const uint32_t *pwDirtyLines, uint_fast16_t hwLine)
+{
+    return (pwDirtyLines[hwLine >> 5] >> (hwLine & 0x1F)) & 1;
+}
+
+//! \brief name of a backend ("framebuffer", "caching"), NULL for an unknown backend
+extern const char *ppu_backend_name(ppu_backend_t tBackend);
+
+//! \brief find a backend by its name, returns false for an unknown name
+extern bool ppu_backend_from_name(const char *pchName, ppu_backend_t *ptBackend);
+
+#endif
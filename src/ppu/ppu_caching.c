@@ -1,125 +1,254 @@
 #include "ppu_caching.h"
+#include "ppu_tile_decode.h"
 #include "nes.h"
 
+#include <string.h>
 #include "jeg_cfg.h"
 
-//! \name PPU Control Register bit mask
-//! @{
-#define PPUCTRL_NAMETABLE                   (3<<0)
-#define PPUCTRL_INCREMENT                   (1<<2)
-#define PPUCTRL_SPRITE_TABLE                (1<<3)
-#define PPUCTRL_BACKGROUND_TABLE            (1<<4)
-#define PPUCTRL_SPRITE_SIZE                 (1<<5)
-#define PPUCTRL_MASTER_SLAVE                (1<<6)
-#define PPUCTRL_NMI                         (1<<7)
-//! @}
-
-//! \name PPU Masking Register Bit Mask
-//! @{
-#define PPUMASK_GRAYSCALE                   (1<<0)
-#define PPUMASK_SHOW_LEFT_BACKGROUND        (1<<1)
-#define PPUMASK_SHOW_LEFT_SPRITES           (1<<2)
-#define PPUMASK_SHOW_BACKGROUND             (1<<3)
-#define PPUMASK_SHOW_SPRITES                (1<<4)
-#define PPUMASK_RED_TINT                    (1<<5)
-#define PPUMASK_GREEN_TINT                  (1<<6)
-#define PPUMASK_BLUE_TINT                   (1<<7)
-//! @}
-
-//! \name PPU status register bit mask
-//! @{
-#define PPUSTATUS_SPRITE_OVERFLOW           (1<<5)
-#define PPUSTATUS_SPRITE_ZERO_HIT           (1<<6)
-#define PPUSTATUS_VBLANK                    (1<<7)
-//! @}
-
-#if JEG_USE_EXTERNAL_DRAW_PIXEL_INTERFACE == ENABLED
-bool ppu_init(ppu_t *ppu, ppu_cfg_t *ptCFG)
-{
-    bool bResult = false;
-    do {
-        if (NULL == ppu || NULL == ptCFG) {
-            break;
-        } else if (     (NULL == ptCFG->ptNES)
-                    ||  (NULL == ptCFG->fnRead)
-                    ||  (NULL == ptCFG->fnWrite)
-                    ||  (NULL == ptCFG->fnDrawPixel)) {
-            break;
-        }
-
-        ppu->nes                = ptCFG->ptNES;
-        ppu->read               = ptCFG->fnRead;
-        ppu->write              = ptCFG->fnWrite;
-        ppu->fnDrawPixel        = ptCFG->fnDrawPixel;
-        ppu->ptTag              = ptCFG->ptTag;
-    #if JEG_USE_EXTERNAL_DRAW_PIXEL_INTERFACE == DISABLED
-        ppu->video_frame_data   = NULL;
-    #endif
-        ppu_reset(ppu);
+static void ppu_reset(nes_t *nes);
+static uint_fast8_t ppu_read(nes_t *ptNES, uint_fast16_t hwAddress);
+static void ppu_write(nes_t *ptNES, uint_fast16_t hwAddress, uint_fast8_t chData);
+static void ppu_write_dma(nes_t *ptNES, uint8_t *pchData);
+static uint_fast32_t ppu_update(nes_t *ptNES);
+#if JEG_USE_SCANLINE_RENDERERS == ENABLED
+static void select_line_renderer(ppu_caching_t *ppu);
+#endif
 
-        bResult = true;
-    } while(false);
-    return bResult;
-}
-#else
-void ppu_init(ppu_t *ppu, nes_t *nes, ppu_read_func_t read, ppu_write_func_t write)
+void ppu_caching_init(nes_t *nes, ppu_caching_t *ppu, uint8_t *video_frame_data)
 {
+    nes->ppu.internal       = ppu;
     ppu->nes                = nes;
-    ppu->read               = read;
-    ppu->write              = write;
-    ppu->video_frame_data   = NULL;
-    ppu_reset(ppu);
+#if JEG_USE_EXTERNAL_DRAW_PIXEL_INTERFACE == ENABLED
+    ppu->fnDrawPixel        = NULL;
+    ppu->ptTag              = NULL;
+#else
+    ppu->video_frame_data   = video_frame_data;
+#endif
+    ppu->tOutput.chFormat   = PPU_PIXEL_INDEX;
+    ppu_reset(nes);
+    nes->ppu.read           = ppu_read;
+    nes->ppu.write          = ppu_write;
+    nes->ppu.write_dma      = ppu_write_dma;
+    nes->ppu.update         = ppu_update;
+    nes->ppu.reset          = ppu_reset;
 }
 
-void ppu_setup_video(ppu_t *ppu, uint8_t *video_frame_data)
+#if JEG_USE_EXTERNAL_DRAW_PIXEL_INTERFACE == ENABLED
+void ppu_caching_setup_draw_pixel(ppu_caching_t *ppu, ppu_draw_pixel_func_t *fnDrawPixel, void *ptTag)
 {
-    ppu->video_frame_data = video_frame_data;
-    memset(ppu->video_frame_data, 0, 256*240);
+    ppu->fnDrawPixel        = fnDrawPixel;
+    ppu->ptTag              = ptTag;
 }
 #endif
 
-
-void ppu_reset(ppu_t *ppu)
+static void ppu_reset(nes_t *nes)
 {
+    ppu_caching_t *ppu = nes->ppu.internal;
+
     ppu->last_cycle_number  = 0;
+    ppu->tRegisterLog.chCount = 0;
     ppu->cycle              = 340;
     ppu->scanline           = 240;
     ppu->ppuctrl            = 0;
     ppu->ppustatus          = 0;
     ppu->t                  = 0;
 
-    memset(&(ppu->tNameAttributeTable[0]), 0, sizeof(name_attribute_table_t));
-    memset(&(ppu->tNameAttributeTable[1]), 0, sizeof(name_attribute_table_t));
-
-#if JEG_USE_4_PHYSICAL_NAME_ATTRIBUTE_TABLES == ENABLED
-    memset(&(ppu->tNameAttributeTable[2]), 0, sizeof(name_attribute_table_t));
-    memset(&(ppu->tNameAttributeTable[3]), 0, sizeof(name_attribute_table_t));
+#if JEG_USE_BACKGROUND_BUFFERING == ENABLED
+    for (uint_fast8_t n = 0; n < UBOUND(ppu->tNameTableBuffer); n++) {
+        name_table_buffer_t *ptBuffer = &ppu->tNameTableBuffer[n];
+
+        memset(ptBuffer, 0, sizeof(name_table_buffer_t));
+        //! the buffer content is unknown, so render every tile once
+        memset(ptBuffer->wDirtyMatrix, 0xFF, sizeof(ptBuffer->wDirtyMatrix));
+        ptBuffer->bRequestRefresh = true;
+        //! the name tables belong to the cartridge (they are kept over a reset): any tile might be in any row
+        for (uint_fast16_t chTile = 0; chTile < 256; chTile++) {
+            ptBuffer->wTileRowIndex[chTile] = _BV(30) - 1;
+        }
+    }
 #endif
 
 #if JEG_USE_SPRITE_BUFFER == ENABLED
     memset(&(ppu->tModifiedSpriteTable), 0, sizeof(sprite_table_t));
     memset(&(ppu->wSpriteBuffer), 0, sizeof(ppu->wSpriteBuffer));
 #endif
+#if JEG_USE_OPTIMIZED_SPRITE_PROCESSING == ENABLED
+    ppu->tSpriteIndex.chHeight = 0;                                             //!< built on the first use
+#endif
+    ppu->sprite_count       = 0;
 
     ppu->ppumask            = 0;
     ppu->oam_address        = 0;
+#if JEG_USE_SCANLINE_RENDERERS == ENABLED
+    select_line_renderer(ppu);
+#endif
     ppu->register_data      = 0;
     ppu->name_table_byte    = 0;
+    ppu_pixel_setup(&ppu->tOutput, (ppu_pixel_format_t)ppu->tOutput.chFormat, ppu->palette, ppu->ppumask);
 
 #if JEG_USE_EXTERNAL_DRAW_PIXEL_INTERFACE == DISABLED
     if (NULL != ppu->video_frame_data) {
-        memset(ppu->video_frame_data, 0, 256*240);
+        ppu_pixel_clear(&ppu->tOutput, ppu->video_frame_data);
     }
+    memset(&ppu->tDirty, 0xFF, sizeof(ppu->tDirty));                           //!< the host has to show the cleared picture
+#endif
+}
+
+//! \brief the name table of an address, the mirroring is resolved by the cartridge
+static inline name_attribute_table_t *get_name_attribute_table(ppu_caching_t *ppu, uint_fast16_t hwAddress)
+{
+    const cartridge_t *ptCartridge = ppu->nes->cartridge.internal;
+    return (name_attribute_table_t *)ptCartridge->pchNameTable[(hwAddress >> 10) & 0x03];
+}
+
+#if JEG_USE_BACKGROUND_BUFFERING == ENABLED
+//! \brief the physical name table (and so the background buffer) of an address
+static inline uint_fast8_t get_physical_name_table(ppu_caching_t *ppu, uint_fast16_t hwAddress)
+{
+    const cartridge_t *ptCartridge = ppu->nes->cartridge.internal;
+    return ptCartridge->chNameTablePage[(hwAddress >> 10) & 0x03];
+}
+
+//! \brief the physical name tables with a background buffer, their data starts at pchNameTableRAM
+static inline uint_fast8_t get_buffered_name_table_count(ppu_caching_t *ppu)
+{
+    const cartridge_t *ptCartridge = ppu->nes->cartridge.internal;
+    return (ptCartridge->chNameTableCount < UBOUND(ppu->tNameTableBuffer))
+        ?   ptCartridge->chNameTableCount
+        :   UBOUND(ppu->tNameTableBuffer);
+}
 #endif
+
+static uint_fast8_t ppu_bus_read(ppu_caching_t *ppu, uint_fast16_t hwAddress)
+{
+    hwAddress &= 0x3FFF;
+
+    if (hwAddress < 0x2000) {
+        return ppu->nes->cartridge.read_chr(ppu->nes->cartridge.internal, hwAddress);
+    } else if (hwAddress < 0x3F00) {
+        return get_name_attribute_table(ppu, hwAddress)->chBuffer[hwAddress & 0x3FF];
+    }
+
+    hwAddress &= 0x1F;
+    if (hwAddress >= 16 && (!(hwAddress & 0x03))) {
+        hwAddress -= 16;
+    }
+    return ppu->palette[hwAddress];
+}
+
+#if JEG_USE_BACKGROUND_BUFFERING == ENABLED
+/*! \brief mark all cells of a name table showing the given tile
+ *! \note  the tile row index is a superset, rows without the tile are removed from it
+ */
+static void mark_tile_dirty(const name_attribute_table_t *ptTable, name_table_buffer_t *ptBuffer, uint_fast8_t chTile)
+{
+    uint_fast32_t wRows = ptBuffer->wTileRowIndex[chTile];
+
+    for (uint_fast8_t chY = 0; wRows; chY++, wRows >>= 1) {
+        uint_fast32_t wLineMask = 0;
+
+        if (!(wRows & 0x01)) {
+            continue;
+        }
+        for (uint_fast8_t chX = 0; chX < 32; chX++) {
+            if (ptTable->chNameTable[chY][chX] == chTile) {
+                wLineMask |= _BV(chX);
+            }
+        }
+
+        if (wLineMask) {
+            ptBuffer->wDirtyMatrix[chY] |= wLineMask;
+            ptBuffer->bRequestRefresh = true;
+        } else {
+            ptBuffer->wTileRowIndex[chTile] &= ~_BV(chY);
+        }
+    }
+}
+
+//! \brief a pattern byte in CHR-RAM has changed, mark the cells showing it (possibly in several banks)
+static void mark_chr_dirty(ppu_caching_t *ppu, uint_fast16_t hwAddress)
+{
+    const uint8_t *pchBank = ppu->nes->cartridge.get_chr_bank(ppu->nes->cartridge.internal, hwAddress);
+    uint_fast8_t chTile = (hwAddress >> 4) & 0x3F;
+    const cartridge_t *ptCartridge = ppu->nes->cartridge.internal;
+
+    for (uint_fast8_t n = 0; n < get_buffered_name_table_count(ppu); n++) {
+        name_table_buffer_t *ptBuffer = &ppu->tNameTableBuffer[n];
+
+        for (uint_fast8_t chSlot = 0; chSlot < 4; chSlot++) {
+            if (ptBuffer->pchPatternBank[chSlot] == pchBank) {
+                mark_tile_dirty((const name_attribute_table_t *)&ptCartridge->pchNameTableRAM[n * 0x400],
+                                ptBuffer, chSlot * 64 + chTile);
+            }
+        }
+    }
+}
+#endif
+
+static void ppu_bus_write(ppu_caching_t *ppu, uint_fast16_t hwAddress, uint_fast8_t chData)
+{
+    hwAddress &= 0x3FFF;
+
+    if (hwAddress < 0x2000) {
+    #if JEG_USE_BACKGROUND_BUFFERING == ENABLED
+        cartridge_t *ptCartridge = ppu->nes->cartridge.internal;
+        uint_fast8_t chOld = ppu->nes->cartridge.read_chr(ptCartridge, hwAddress);
+
+        ppu->nes->cartridge.write_chr(ptCartridge, hwAddress, chData);
+
+        //! CHR-ROM ignores the write, so check the result instead of chData
+        if (chOld != ppu->nes->cartridge.read_chr(ptCartridge, hwAddress)) {
+            mark_chr_dirty(ppu, hwAddress);
+        }
+    #else
+        ppu->nes->cartridge.write_chr(ppu->nes->cartridge.internal, hwAddress, chData);
+    #endif
+    } else if (hwAddress < 0x3F00) {
+        name_attribute_table_t *ptTable = get_name_attribute_table(ppu, hwAddress);
+    #if JEG_USE_BACKGROUND_BUFFERING == ENABLED
+        uint_fast8_t chPhysical = get_physical_name_table(ppu, hwAddress);
+    #endif
+        hwAddress &= 0x3FF;
+
+    #if JEG_USE_BACKGROUND_BUFFERING == ENABLED
+        //! tables without a buffer (four screen boards) are decoded per tile
+        if (chPhysical < UBOUND(ppu->tNameTableBuffer) && ptTable->chBuffer[hwAddress] != chData) {
+            name_table_buffer_t *ptBuffer = &ppu->tNameTableBuffer[chPhysical];
+
+            if (hwAddress < 960) {
+                //! name table: a single tile
+                ptBuffer->wDirtyMatrix[hwAddress >> 5] |= _BV(hwAddress & 0x1F);
+                ptBuffer->wTileRowIndex[chData] |= _BV(hwAddress >> 5);
+            } else {
+                //! attribute table: a group of 4x4 tiles
+                uint_fast8_t chY = ((hwAddress - 960) >> 3) * 4;
+                uint_fast32_t wMask = 0x0F << (((hwAddress - 960) & 0x07) * 4);
+                for (uint_fast8_t n = 0; n < 4 && chY < 30; n++, chY++) {
+                    ptBuffer->wDirtyMatrix[chY] |= wMask;
+                }
+            }
+            ptBuffer->bRequestRefresh = true;
+        }
+    #endif
+        ptTable->chBuffer[hwAddress] = chData;
+    } else {
+        hwAddress &= 0x1F;
+        if (hwAddress >= 16 && (!(hwAddress & 0x03))) {
+            hwAddress -= 16;
+        }
+        ppu->palette[hwAddress] = chData;
+        ppu_pixel_update_entry(&ppu->tOutput, hwAddress, chData);
+    }
 }
 
-uint_fast8_t ppu_read(ppu_t *ppu, uint_fast16_t hwAddress)
+static uint_fast8_t ppu_read(nes_t *ptNES, uint_fast16_t hwAddress)
 {
     int value, buffered;
+    ppu_caching_t *ppu = ptNES->ppu.internal;
 
     switch (hwAddress & 0x07) {
         case 2:
-            ppu_update(ppu);
+            ppu_update(ptNES);
             value=      (ppu->register_data & 0x1F)
                     |   (ppu->ppustatus & (     PPUSTATUS_VBLANK
                                             |   PPUSTATUS_SPRITE_ZERO_HIT
@@ -134,13 +263,14 @@ uint_fast8_t ppu_read(ppu_t *ppu, uint_fast16_t hwAddress)
             break;
 
         case 7:
-            value=ppu->read(ppu->nes, ppu->v);
+            ppu_update(ptNES);
+            value=ppu_bus_read(ppu, ppu->v);
             if ((ppu->v & 0x3FFF) < 0x3F00) {
                 buffered = ppu->buffered_data;
                 ppu->buffered_data = value;
                 value = buffered;
             } else {
-                ppu->buffered_data = ppu->read(ppu->nes, ppu->v - 0x1000);
+                ppu->buffered_data = ppu_bus_read(ppu, ppu->v - 0x1000);
             }
             ppu->v += ((ppu->ppuctrl&PPUCTRL_INCREMENT) == 0) ? 1 : 32;
             break;
@@ -152,136 +282,78 @@ uint_fast8_t ppu_read(ppu_t *ppu, uint_fast16_t hwAddress)
     return value;
 }
 
-void ppu_dma_access(ppu_t *ppu, uint_fast8_t chData)
+static void ppu_write_dma(nes_t *ptNES, uint8_t *pchData)
 {
-    uint_fast16_t address_temp = chData << 8;
-
-
-#if JEG_USE_DMA_MEMORY_COPY_ACCELERATION == ENABLED
-    assert(0 == ppu->oam_address);
-    uint8_t *pchSrc = ppu->nes->cpu.fnDMAGetSourceAddress(ppu->nes, address_temp);
-
-#   if JEG_USE_OPTIMIZED_SPRITE_PROCESSING == ENABLED
-    uint8_t *pchCheck = pchSrc;
-#       if JEG_USE_SPRITE_BUFFER == ENABLED
-    uint8_t *pchOAM = ppu->tModifiedSpriteTable.chBuffer;
-#       else
-    uint8_t *pchOAM = ppu->tSpriteTable.chBuffer;
-#endif
-    uint_fast8_t n = 64;
-    do {
-        if (*pchCheck != *pchOAM) {
-            ppu->bOAMUpdated = true;
-            break;
-        }
-        pchCheck += 4;
-        pchOAM += 4;
-    } while(--n);
-#   endif
+    ppu_caching_t *ppu = ptNES->ppu.internal;
 
-#   if JEG_USE_SPRITE_BUFFER == ENABLED
-    memcpy(&(ppu->tModifiedSpriteTable.chBuffer[0]), pchSrc, 256);
+#if JEG_USE_SPRITE_BUFFER == ENABLED
+    ppu_oam_dma_copy(ppu->tModifiedSpriteTable.chBuffer, ppu->oam_address & 0xFF, pchData);
     ppu->bRequestRefreshSpriteBuffer = true;
-#   else
-    memcpy(&(ppu->tSpriteTable.chBuffer[0]), pchSrc, 256);
+#else
+    ppu_oam_dma_copy(ppu->tSpriteTable.chBuffer, ppu->oam_address & 0xFF, pchData);
+#   if JEG_USE_OPTIMIZED_SPRITE_PROCESSING == ENABLED
+    ppu_sprite_index_update(&ppu->tSpriteIndex, &ppu->tSpriteTable);
 #   endif
+#endif
+}
 
-#else
-    for(uint_fast16_t i=0; i<256; i++) {
-        uint_fast8_t v = ppu->nes->cpu.read(ppu->nes, address_temp++);
+/*! \brief log a write to $2000, $2001, $2005 or $2006, see write_register()
+ *! \note  the cartridge is told about a new pattern fetch configuration right
+ *!        away, it follows the cpu and not the (late) ppu
+ */
+static void log_register_write(nes_t *ptNES, uint_fast8_t chRegister, uint_fast8_t chData)
+{
+    ppu_caching_t *ppu = ptNES->ppu.internal;
+    uint_fast8_t chPPUCtrl, chPPUMask;
 
-#   if JEG_USE_SPRITE_BUFFER == ENABLED
-        ppu->tModifiedSpriteTable.chBuffer[(ppu->oam_address + i) & 0xFF] = v;
-#   else
-#       if JEG_USE_OPTIMIZED_SPRITE_PROCESSING == ENABLED
-        if (!(i & 0x03)) {
-            if (ppu->tSpriteTable.chBuffer[(ppu->oam_address + i) & 0xFF] != v) {
-                ppu->bOAMUpdated = true;
-            }
-        }
-#       endif
-        ppu->tSpriteTable.chBuffer[(ppu->oam_address + i) & 0xFF] = v;
-#   endif
+    if (PPU_REGISTER_LOG_SIZE == ppu->tRegisterLog.chCount) {
+        ppu_update(ptNES);
     }
-#   if JEG_USE_SPRITE_BUFFER == ENABLED
-    ppu->bRequestRefreshSpriteBuffer = true;
-#endif
-#endif
 
-    ppu->nes->cpu.stall_cycles += 513;
-    if (ppu->nes->cpu.cycle_number & 0x01) {
-        ppu->nes->cpu.stall_cycles++;
+    chPPUCtrl = ppu_register_log_latest(&ppu->tRegisterLog, 0, ppu->ppuctrl);
+    chPPUMask = ppu_register_log_latest(&ppu->tRegisterLog, 1, ppu->ppumask);
+    if (    (0 == chRegister && ((chPPUCtrl ^ chData) & PPUCTRL_PATTERN_FETCH))
+        ||  (1 == chRegister && ((chPPUMask ^ chData) & PPUMASK_PATTERN_FETCH))) {
+        ppu_report_pattern_fetch(ptNES, ppu->last_cycle_number, ppu->scanline, ppu->cycle,
+                                 0 == chRegister ? chData : chPPUCtrl,
+                                 1 == chRegister ? chData : chPPUMask);
     }
+
+    ppu_register_log_push(&ppu->tRegisterLog, ptNES->cpu.cycle_number, chRegister, chData);
 }
 
-void ppu_write(ppu_t *ppu, uint_fast16_t hwAddress, uint_fast8_t chData)
+static void ppu_write(nes_t *ptNES, uint_fast16_t hwAddress, uint_fast8_t chData)
 {
+    ppu_caching_t *ppu = ptNES->ppu.internal;
     ppu->register_data = chData;
 
     switch (hwAddress & 7) {
         case 0:
-            ppu->ppuctrl=chData;
-            ppu->t = (ppu->t & 0xF3FF) | ((chData & 0x03) <<10 );               //! select name/attribute tables
-            break;
         case 1:
-            ppu->ppumask=chData;
+        case 5:
+        case 6:
+            log_register_write(ptNES, hwAddress & 7, chData);
             break;
         case 3:
             ppu->oam_address=chData;
             break;
         case 4:
-
-
-
         #if JEG_USE_SPRITE_BUFFER == ENABLED
-
-        #   if JEG_USE_OPTIMIZED_SPRITE_PROCESSING == ENABLED
-            if (!(ppu->oam_address & 0x03)) {
-                uint_fast8_t chOld = ppu->tModifiedSpriteTable.chBuffer[ppu->oam_address];
-                if (chOld != chData) {
-                    ppu->bOAMUpdated = true;
-                }
-            }
-        #   endif
+            //! the index follows tSpriteTable in update_sprite_buffer()
             ppu->bRequestRefreshSpriteBuffer = true;
             ppu->tModifiedSpriteTable.chBuffer[ppu->oam_address++] = chData;
         #else
-
         #   if JEG_USE_OPTIMIZED_SPRITE_PROCESSING == ENABLED
             if (!(ppu->oam_address & 0x03)) {
-                uint_fast8_t chOld = ppu->tSpriteTable.chBuffer[ppu->oam_address];
-                if (chOld != chData) {
-                    ppu->bOAMUpdated = true;
-                }
+                ppu_sprite_index_move(&ppu->tSpriteIndex, ppu->oam_address >> 2, chData);
             }
         #   endif
             ppu->tSpriteTable.chBuffer[ppu->oam_address++] = chData;
         #endif
             break;
-        case 5:
-            ppu_update(ppu);
-            if (0 == ppu->w) {
-                ppu->t = ( ppu->t & 0xFFE0 ) | ( chData>>3 );
-                ppu->x = chData & 0x07;
-                ppu->w = 1;
-            } else {
-                ppu->t = (ppu->t & 0x8FFF) | ((chData&0x07)<<12);
-                ppu->t = (ppu->t & 0xFC1F) | ((chData&0xF8)<<2);
-                ppu->w = 0;
-            }
-            break;
-        case 6:
-            if (0 == ppu->w) {
-                ppu->t = (ppu->t&0x80FF) | ((chData&0x3F)<<8);
-                ppu->w = 1;
-            } else {
-                ppu->t = (ppu->t&0xFF00) | chData;
-                ppu->v = ppu->t;
-                ppu->w = 0;
-            }
-            break;
         case 7:
-            ppu->write(ppu->nes, ppu->v, chData);
+            ppu_update(ptNES);                                                  //!< v and the vram as seen by the cpu
+            ppu_bus_write(ppu, ppu->v, chData);
             ppu->v += (0 == (ppu->ppuctrl & PPUCTRL_INCREMENT)) ? 1:32;
             break;
     }
@@ -290,7 +362,7 @@ void ppu_write(ppu_t *ppu, uint_fast16_t hwAddress, uint_fast8_t chData)
 
 
 
-static uint32_t fetch_sprite_pattern(ppu_t *ppu, sprite_t *ptSpriteInfo, uint_fast16_t hwRow)
+static uint32_t fetch_sprite_pattern(ppu_caching_t *ppu, sprite_t *ptSpriteInfo, uint_fast16_t hwRow)
 {
     uint_fast8_t tile = ptSpriteInfo->chIndex;
     uint_fast8_t chAttributes =  ptSpriteInfo->Attributes.chValue;
@@ -317,38 +389,20 @@ static uint32_t fetch_sprite_pattern(ppu_t *ppu, sprite_t *ptSpriteInfo, uint_fa
 
     hwAddress = 0x1000 * table + tile * 16 + hwRow;
 
-    uint_fast8_t low_tile_byte = ppu->read(ppu->nes, hwAddress);
-    uint_fast8_t high_tile_byte = ppu->read(ppu->nes, hwAddress + 8);
-    uint32_t data=0;
-
-    uint_fast8_t p1, p2;
-    if (chAttributes & 0x40) {
-        uint_fast8_t n = 8;
-        do {
-            p1= (low_tile_byte & 0x01);
-            p2= (high_tile_byte & 0x01) << 1;
-            low_tile_byte >>= 1;
-            high_tile_byte >>= 1;
-
-            data |= (((chAttributes & 3) << 2) | p1 | p2) << (4 * (8-n));
-        } while(--n);
-    } else {
-        uint_fast8_t n = 8;
-        do {
-            p1 = (low_tile_byte & 0x80) >> 7;
-            p2 = (high_tile_byte & 0x80) >> 6;
-            low_tile_byte <<= 1;
-            high_tile_byte <<= 1;
+    uint32_t data = ppu_tile_decode_row(ppu_bus_read(ppu, hwAddress),
+                                        ppu_bus_read(ppu, hwAddress + 8),
+                                        (chAttributes & 3) << 2);
 
-            data |= (((chAttributes & 3) << 2) | p1 | p2) << (4 * (8-n));
-        } while(--n);
+    //! the leftmost pixel is expected in the lowest nibble
+    if (!(chAttributes & 0x40)) {
+        data = ppu_tile_mirror_row(data);
     }
 
     return data;
 }
 
 #if JEG_USE_SPRITE_BUFFER == ENABLED
-static void update_sprite_buffer(ppu_t *ptPPU)
+static void update_sprite_buffer(ppu_caching_t *ptPPU)
 {
     if (!ptPPU->bRequestRefreshSpriteBuffer) {
         return ;
@@ -379,98 +433,45 @@ static void update_sprite_buffer(ppu_t *ptPPU)
         ptOriginal++;
         ptNew++;
     }
-}
-
-#endif
-
 #if JEG_USE_OPTIMIZED_SPRITE_PROCESSING == ENABLED
-static void sort_sprite_order_list(ppu_t *ptPPU)
-{
-    //! a very simple & stupid sorting algorithm
-    uint_fast8_t chIndex = 0, n;
-
-    if (!ptPPU->bOAMUpdated) {
-        return ;
-    }
-    ptPPU->bOAMUpdated = false;
-
-    //! initialise the list
-    for (;chIndex < 64; chIndex++) {
-        ptPPU->SpriteYOrderList.List[chIndex].chIndex = chIndex;
-        ptPPU->SpriteYOrderList.List[chIndex].chY = ptPPU->tSpriteTable.SpriteInfo[chIndex].chY;
-    }
-
-    //! sort the list
-    for (chIndex = 0; chIndex < 64; chIndex++) {
-        uint_fast16_t hwMin = 0xFFFF;
-        uint_fast16_t hwMinIndex = chIndex;
-        for (n = chIndex; n < 64; n++) {
-            if (ptPPU->SpriteYOrderList.List[n].chY < hwMin) {
-                hwMinIndex = n;
-                hwMin = ptPPU->SpriteYOrderList.List[n].chY;
-            }
-        }
-
-        if (hwMin >= 240) {
-            //! no need to do it.
-            break;
-        } else if (chIndex == hwMinIndex) {
-            continue;
-        }
-
-        //! swap
-
-        do {
-            uint_fast8_t chTempIndex = ptPPU->SpriteYOrderList.List[hwMinIndex].chIndex;
-
-            ptPPU->SpriteYOrderList.List[hwMinIndex].chIndex = ptPPU->SpriteYOrderList.List[chIndex].chIndex;
-            ptPPU->SpriteYOrderList.List[hwMinIndex].chY = ptPPU->SpriteYOrderList.List[chIndex].chY;
-
-            ptPPU->SpriteYOrderList.List[chIndex].chIndex = chTempIndex;
-            ptPPU->SpriteYOrderList.List[chIndex].chY = hwMin;
-        } while(false);
-    }
-
-    ptPPU->SpriteYOrderList.chVisibleCount = chIndex;
-    ptPPU->SpriteYOrderList.chCurrent = 0;
+    ppu_sprite_index_update(&ptPPU->tSpriteIndex, &ptPPU->tSpriteTable);
+#endif
 }
+
 #endif
 
-static inline uint_fast8_t fetch_sprite_info_on_specified_line(ppu_t *ptPPU, uint_fast32_t nScanLine)
+static inline uint_fast8_t fetch_sprite_info_on_specified_line(ppu_caching_t *ptPPU, uint_fast32_t nScanLine)
 {
     uint_fast8_t chCount = 0;
     uint_fast8_t chSpriteSize = ((ptPPU->ppuctrl & PPUCTRL_SPRITE_SIZE) ? 16 : 8);
 
-#if JEG_USE_OPTIMIZED_SPRITE_PROCESSING == ENABLED
+    memset(ptPPU->chSpriteLine, 0, sizeof(ptPPU->chSpriteLine));
 
-    for(int_fast32_t j = ptPPU->SpriteYOrderList.chCurrent; j < ptPPU->SpriteYOrderList.chVisibleCount; j++) {
-        uint_fast8_t chIndex = ptPPU->SpriteYOrderList.List[j].chIndex;
+#if JEG_USE_OPTIMIZED_SPRITE_PROCESSING == ENABLED
+    //! the sprites of the line in OAM order, taken from the index
+    uint64_t dwSprites = ppu_sprite_index_line(&ptPPU->tSpriteIndex, &ptPPU->tSpriteTable, nScanLine, chSpriteSize);
 
-        int_fast32_t row = nScanLine - ptPPU->SpriteYOrderList.List[j].chY;
-        if (row < 0) {
-            continue;
-        } else if (row >= chSpriteSize) {
-            //! don't check previous sprites
-            ptPPU->SpriteYOrderList.chCurrent++;
-            continue;
-        }
+    if (ppu_sprite_count(dwSprites) > 8) {
+        ptPPU->ppustatus |= PPUSTATUS_SPRITE_OVERFLOW;
+    }
+    for (; dwSprites && chCount < JEG_MAX_ALLOWED_SPRITES_ON_SINGLE_SCANLINE; dwSprites &= dwSprites - 1) {
+        uint_fast8_t chIndex = ppu_sprite_first(dwSprites);
+        sprite_t *ptSprite = &ptPPU->tSpriteTable.SpriteInfo[chIndex];
+        uint_fast16_t row = nScanLine - ptSprite->chY;
 
-        if (chCount < JEG_MAX_ALLOWED_SPRITES_ON_SINGLE_SCANLINE) {
 #   if JEG_USE_SPRITE_BUFFER == ENABLED
-            ptPPU->sprite_patterns[chCount] = ptPPU->wSpriteBuffer[chIndex][row];           //!< Debug: why this doesn't work for Road Fighter?
-            //ptPPU->sprite_patterns[chCount]   = fetch_sprite_pattern(ptPPU, ptPPU->tSpriteTable.SpriteInfo + chIndex, row);
+        uint32_t wPattern = ptPPU->wSpriteBuffer[chIndex][row];                 //!< Debug: why this doesn't work for Road Fighter?
 #   else
-            ptPPU->sprite_patterns[chCount]   = fetch_sprite_pattern(ptPPU, ptPPU->tSpriteTable.SpriteInfo + chIndex, row);
+        uint32_t wPattern = fetch_sprite_pattern(ptPPU, ptSprite, row);
 #   endif
-            ptPPU->sprite_positions[chCount]  = ptPPU->tSpriteTable.SpriteInfo[chIndex].chPosition;
-            ptPPU->sprite_priorities[chCount] = ptPPU->tSpriteTable.SpriteInfo[chIndex].Attributes.Priority;
-            ptPPU->sprite_indicies[chCount]   = chIndex;
-            chCount++;
-        } else {
-            break;
-        }
+        ppu_sprite_line_draw(ptPPU->chSpriteLine, wPattern, ptSprite->chPosition,
+                             ppu_sprite_line_flags(ptSprite, chIndex));
+        chCount++;
     }
+    return chCount;
 #else
+    uint_fast8_t chInRange = 0;
+
     // evaluate sprite
     for(int_fast32_t j = 0; j < 64; j++) {
         int_fast32_t row = ptPPU->scanline-ptPPU->tSpriteTable.SpriteInfo[j].chY;
@@ -478,42 +479,60 @@ static inline uint_fast8_t fetch_sprite_info_on_specified_line(ppu_t *ptPPU, uin
             ||  (row >= chSpriteSize)) {
             continue;
         }
+        chInRange++;
         if (chCount < JEG_MAX_ALLOWED_SPRITES_ON_SINGLE_SCANLINE) {
-            ptPPU->sprite_patterns[chCount]   = fetch_sprite_pattern(ptPPU, ptPPU->tSpriteTable.SpriteInfo + j, row);
-            ptPPU->sprite_positions[chCount]  = ptPPU->tSpriteTable.SpriteInfo[j].chPosition;
-            ptPPU->sprite_priorities[chCount] = ptPPU->tSpriteTable.SpriteInfo[j].Attributes.Priority;
-            ptPPU->sprite_indicies[chCount]   = j;
+            sprite_t *ptSprite = &ptPPU->tSpriteTable.SpriteInfo[j];
+
+            ppu_sprite_line_draw(ptPPU->chSpriteLine, fetch_sprite_pattern(ptPPU, ptSprite, row),
+                                 ptSprite->chPosition, ppu_sprite_line_flags(ptSprite, j));
             chCount++;
         }
     }
-#endif
 
-    if (chCount > 8) {
+    if (chInRange > 8) {
         ptPPU->ppustatus |= PPUSTATUS_SPRITE_OVERFLOW;
     }
     return chCount;
+#endif
 }
 
 #if JEG_USE_BACKGROUND_BUFFERING == ENABLED
-static void update_background(ppu_t *ptPPU)
+static void update_background(ppu_caching_t *ptPPU)
 {
-    uint_fast8_t n = UBOUND(ptPPU->tNameAttributeTable);
-    name_attribute_table_t *ptTable = ptPPU->tNameAttributeTable;
+    const cartridge_t *ptCartridge = ptPPU->nes->cartridge.internal;
+    uint_fast8_t n = get_buffered_name_table_count(ptPPU);
+    const name_attribute_table_t *ptTable = (const name_attribute_table_t *)ptCartridge->pchNameTableRAM;
+    name_table_buffer_t *ptBuffer = ptPPU->tNameTableBuffer;
+    uint_fast16_t hwPatternTable = (ptPPU->ppuctrl & PPUCTRL_BACKGROUND_TABLE) ? 0x1000 : 0;
+    const uint8_t *pchPatternBank[4];
+
+    for (uint_fast8_t chSlot = 0; chSlot < 4; chSlot++) {
+        pchPatternBank[chSlot] = ptPPU->nes->cartridge.get_chr_bank(ptPPU->nes->cartridge.internal,
+                                                                    hwPatternTable + chSlot * 0x400);
+    }
 
     do {
         uint_fast16_t hwAddress = 0;
-        if (ptTable->bRequestRefresh) {
-            ptTable->bRequestRefresh = false;
+
+        if (memcmp(ptBuffer->pchPatternBank, pchPatternBank, sizeof(pchPatternBank))) {
+            //! the background pattern table or a CHR bank is switched: every tile changes
+            memcpy(ptBuffer->pchPatternBank, pchPatternBank, sizeof(pchPatternBank));
+            memset(ptBuffer->wDirtyMatrix, 0xFF, sizeof(ptBuffer->wDirtyMatrix));
+            ptBuffer->bRequestRefresh = true;
+        }
+
+        if (ptBuffer->bRequestRefresh) {
+            ptBuffer->bRequestRefresh = false;
 
             for (uint_fast8_t chY = 0; chY < 30; chY++) {
 
-                uint_fast32_t wLineMask = ptTable->wDirtyMatrix[chY];
+                uint_fast32_t wLineMask = ptBuffer->wDirtyMatrix[chY];
                 if (0 == wLineMask) {
                     hwAddress += 32;
                     continue;
                 }
 
-                ptTable->wDirtyMatrix[chY] = 0;
+                ptBuffer->wDirtyMatrix[chY] = 0;
 
                 for (uint_fast8_t chX = 0; chX < 32; chX++) {
 
@@ -536,64 +555,14 @@ static void update_background(ppu_t *ptPPU)
                                                 ) & 3
                           ) << 2;
 
+                    const uint8_t *pchPattern = &pchPatternBank[name_table_byte >> 6][(name_table_byte & 0x3F) * 16];
                     for (uint_fast8_t chYOffsite = 0; chYOffsite < 8; chYOffsite++) {
-                        //!< fetch low tile byte
-                        uint_fast8_t low_tile_byte = ptPPU->read (
-                                    ptPPU->nes,
-                                    0x1000*((ptPPU->ppuctrl & PPUCTRL_BACKGROUND_TABLE) ? 1 : 0)
-                                +   name_table_byte*16
-                                +   chYOffsite
-                            );
-
-
-                        //!< fetch high tile byte
-                        uint_fast8_t high_tile_byte = ptPPU->read(
-                                    ptPPU->nes,
-                                    0x1000 * ((ptPPU->ppuctrl & PPUCTRL_BACKGROUND_TABLE) ? 1 : 0)
-                                +   name_table_byte*16
-                                +   chYOffsite + 8
-                            );
-
                         //! \note the orders of 8 pixels are changed in order to use 32bit copy optimisation.
-                        //! @{
-                        compact_dual_pixels_t *ptLine = &(ptTable->chBackgroundBuffer[chY*8 + chYOffsite][chX * 4]);
-                        //!< store tile data
-
-                        uint_fast8_t n = 4;
-                        do {
-                        #if false
-                            ptLine->Low =     attribute_table_byte
-                                        |   ((low_tile_byte  & 0x80) >> 7)
-                                        |   ((high_tile_byte & 0x80) >> 6);
-
-                            low_tile_byte <<= 1;
-                            high_tile_byte <<= 1;
-
-                            ptLine->High =     attribute_table_byte
-                                        |   ((low_tile_byte  & 0x80) >> 7)
-                                        |   ((high_tile_byte & 0x80) >> 6);
-
-                            low_tile_byte <<= 1;
-                            high_tile_byte <<= 1;
-                        #else
-                            ptLine->Low =     attribute_table_byte
-                                        |   ((low_tile_byte  & 0x01))
-                                        |   ((high_tile_byte & 0x01) << 1);
-
-                            low_tile_byte >>= 1;
-                            high_tile_byte >>= 1;
-
-                            ptLine->High =     attribute_table_byte
-                                        |   ((low_tile_byte  & 0x01))
-                                        |   ((high_tile_byte & 0x01) << 1);
-
-                            low_tile_byte >>= 1;
-                            high_tile_byte >>= 1;
-                        #endif
-
-                            ptLine++;
-                        } while(--n);
-                        //! @}
+                        uint32_t wRow = ppu_tile_decode_row(pchPattern[chYOffsite],
+                                                            pchPattern[chYOffsite + 8],
+                                                            attribute_table_byte);
+
+                        memcpy(&(ptBuffer->chBackgroundBuffer[chY*8 + chYOffsite][chX * 4]), &wRow, sizeof(wRow));
                     }
 
                     hwAddress++;
@@ -601,23 +570,19 @@ static void update_background(ppu_t *ptPPU)
             }
         }
         ptTable++;
+        ptBuffer++;
 
     } while(--n);
 }
 #endif
 
-static void fetch_background_tile_info(ppu_t *ptPPU)
+static void fetch_background_tile_info(ppu_caching_t *ptPPU)
 {
-    bool bReadInfo = true;
 #if JEG_USE_BACKGROUND_BUFFERING != ENABLED
 
-    uint_fast32_t data = 0;
     ptPPU->tile_data <<= 4;
 
-    uint_fast8_t chTableIndex = find_name_attribute_table_index(
-                                        ptPPU->nes->cartridge.mirror,
-                                        ptPPU->v & 0x0FFF);
-    name_attribute_table_t *ptTable = &(ptPPU->tNameAttributeTable[chTableIndex]);
+    name_attribute_table_t *ptTable = get_name_attribute_table(ptPPU, ptPPU->v);
 
     uint_fast16_t hwAddress = ptPPU->v & 0x3FF;
 
@@ -637,8 +602,8 @@ static void fetch_background_tile_info(ppu_t *ptPPU)
             break;
 
         case 5:                                                     //!< fetch low tile byte
-            ptPPU->low_tile_byte = ptPPU->read (
-                        ptPPU->nes,
+            ptPPU->low_tile_byte = ppu_bus_read (
+                        ptPPU,
                         0x1000*((ptPPU->ppuctrl & PPUCTRL_BACKGROUND_TABLE) ? 1 : 0)
                     +   ptPPU->name_table_byte*16
                     +   ptPPU->tVAddress.TileYOffsite
@@ -646,8 +611,8 @@ static void fetch_background_tile_info(ppu_t *ptPPU)
             break;
 
         case 7:                                                     //!< fetch high tile byte
-            ptPPU->high_tile_byte = ptPPU->read(
-                        ptPPU->nes,
+            ptPPU->high_tile_byte = ppu_bus_read(
+                        ptPPU,
                         0x1000 * ((ptPPU->ppuctrl & PPUCTRL_BACKGROUND_TABLE) ? 1 : 0)
                     +   ptPPU->name_table_byte*16
                     +   ptPPU->tVAddress.TileYOffsite + 8
@@ -655,32 +620,37 @@ static void fetch_background_tile_info(ppu_t *ptPPU)
             break;
 
         case 0:                                                     //!< store tile data
-            for(int_fast32_t j = 0; j<8; j++) {
-                data <<= 4;
-                data |=     ptPPU->attribute_table_byte
-                        |   ((ptPPU->low_tile_byte  & 0x80) >> 7)
-                        |   ((ptPPU->high_tile_byte & 0x80) >> 6);
-
-                ptPPU->low_tile_byte <<= 1;
-                ptPPU->high_tile_byte <<= 1;
-            }
-            ptPPU->tile_data |= data;
+            ptPPU->tile_data |= ppu_tile_decode_row(ptPPU->low_tile_byte,
+                                                    ptPPU->high_tile_byte,
+                                                    ptPPU->attribute_table_byte);
             break;
     }
 
 #else
+    bool bReadInfo = true;
+
     ptPPU->tile_data <<= 4;
     if (!(ptPPU->cycle & 0x07)) {
 
         //uint_fast32_t data = 0;
-        uint_fast8_t chTableIndex =
-        find_name_attribute_table_index(ptPPU->nes->cartridge.chMirror, (ptPPU->v&0x0FFF));
-
-        name_attribute_table_t *ptTable = &(ptPPU->tNameAttributeTable[chTableIndex]);
-
-        if (bReadInfo) {
+        uint_fast8_t chPhysical = get_physical_name_table(ptPPU, ptPPU->v);
+
+        if (chPhysical >= UBOUND(ptPPU->tNameTableBuffer)) {
+            //! a four screen table without a buffer: decode the tile row like the ppu does
+            const name_attribute_table_t *ptTable = get_name_attribute_table(ptPPU, ptPPU->v);
+            uint_fast16_t hwPattern =   ((ptPPU->ppuctrl & PPUCTRL_BACKGROUND_TABLE) ? 0x1000 : 0)
+                                    +   ptTable->chBuffer[ptPPU->v & 0x3FF] * 16
+                                    +   ptPPU->tVAddress.TileYOffsite;
+            uint_fast8_t chAttribute = ptTable->AttributeTable[ptPPU->tVAddress.YScroll>>2][ptPPU->tVAddress.XScroll>>2].chValue;
+
+            chAttribute = ((chAttribute >> (((ptPPU->v>>4) & 4) | (ptPPU->v&2))) & 3) << 2;
+            ptPPU->tile_data |= ppu_tile_decode_row(ppu_bus_read(ptPPU, hwPattern),
+                                                    ppu_bus_read(ptPPU, hwPattern + 8),
+                                                    chAttribute);
+        } else if (bReadInfo) {
+            name_table_buffer_t *ptBuffer = &ptPPU->tNameTableBuffer[chPhysical];
             uint_fast8_t chY = (ptPPU->tVAddress.YScroll * 8) + ptPPU->tVAddress.TileYOffsite;
-            compact_dual_pixels_t *ptLine = &(ptTable->chBackgroundBuffer[chY][ptPPU->tVAddress.XScroll * 4]);
+            compact_dual_pixels_t *ptLine = &(ptBuffer->chBackgroundBuffer[chY][ptPPU->tVAddress.XScroll * 4]);
 
             /*! \note the orders of 8 pixels are changed in order to use 32bit copy optimisation. */
             ptPPU->tile_data |= *((uint32_t *)ptLine);
@@ -690,73 +660,46 @@ static void fetch_background_tile_info(ppu_t *ptPPU)
 }
 
 
-static void ppu_mix_background_and_foreground(ppu_t *ptPPU)
+//! \brief draw the pixel of the current dot, chMask is PPUMASK (a constant in the scanline renderers)
+static JEG_ALWAYS_INLINE void ppu_mix_background_and_foreground(ppu_caching_t *ptPPU, uint_fast8_t chMask)
 {
     //! render pixel
-    uint_fast8_t background = 0, i = 0, sprite = 0;
+    uint_fast8_t background = 0, sprite = 0, color = 0;
 
-    //! get sprite pixel color
-    if (ptPPU->ppumask & PPUMASK_SHOW_SPRITES) {
-
-        for(uint_fast8_t j = 0; j < ptPPU->sprite_count; j++) {
-            int_fast16_t offset =   (ptPPU->cycle - 1)
-                                  - (int_fast16_t)ptPPU->sprite_positions[j];
-
-            if ( offset < 0 || offset > 7) {
-                continue;
-            }
-
-            //int_fast32_t color = (ptPPU->sprite_patterns[j] >> ((7 - offset) * 4)) & 0x0F;
-            int_fast32_t color = (ptPPU->sprite_patterns[j] >> ((offset) * 4)) & 0x0F;
-            if (!(color & 0x03)) {
-                continue;
-            }
-
-            i = j;
-            sprite = color;
-            break;
-        }
+    //! get sprite pixel color, rasterized for the whole line at the sprite evaluation
+    if (ptPPU->sprite_count && (chMask & PPUMASK_SHOW_SPRITES)) {
+        sprite = ptPPU->chSpriteLine[ptPPU->cycle - 1];
     }
 
-    uint_fast8_t s = (sprite & 0x03), color = 0;
-
     //! get background pixel color
-    if ((ptPPU->ppumask&PPUMASK_SHOW_BACKGROUND) != 0) {
+    if ((chMask & PPUMASK_SHOW_BACKGROUND) != 0) {
         background = (ptPPU->tile_data >> (32 + ((7-ptPPU->x) * 4)) ) & 0x0F;
     }
 
     if ((ptPPU->cycle - 1) < 8) {
-        if ((ptPPU->ppumask & PPUMASK_SHOW_LEFT_BACKGROUND) == 0) {
+        if ((chMask & PPUMASK_SHOW_LEFT_BACKGROUND) == 0) {
             background = 0;
         }
-        if ((ptPPU->ppumask & PPUMASK_SHOW_LEFT_SPRITES) == 0) {
+        if ((chMask & PPUMASK_SHOW_LEFT_SPRITES) == 0) {
             sprite = 0;
         }
     }
 
-    uint_fast8_t b = (background & 0x03);
-
-    if (!b && s) {
-        color = sprite | 0x10;
-    } else if (b && !s) {
+    if (!(background & 0x03)) {
+        color = sprite ? ((sprite & PPU_SPRITE_PIXEL_COLOR) | 0x10) : 0;
+    } else if (!sprite) {
         color = background;
-    } else if (b && s) {
-
-        if (    (ptPPU->sprite_indicies[i] == 0)
+    } else {
+        if (    (sprite & PPU_SPRITE_PIXEL_ZERO)
             &&  ((ptPPU->cycle - 1) < 255)) {
             ptPPU->ppustatus |= PPUSTATUS_SPRITE_ZERO_HIT;
         }
 
-        if (ptPPU->sprite_priorities[i] == 0) {
-            color = sprite | 0x10;
-        } else {
+        if (sprite & PPU_SPRITE_PIXEL_BEHIND) {
             color = background;
+        } else {
+            color = (sprite & PPU_SPRITE_PIXEL_COLOR) | 0x10;
         }
-
-    }
-
-    if ( color >= 16 && !(color & 0x03)) {
-        color -= 16;
     }
 #if JEG_USE_EXTERNAL_DRAW_PIXEL_INTERFACE == ENABLED
     ptPPU->fnDrawPixel(   ptPPU->ptTag,
@@ -764,13 +707,80 @@ static void ppu_mix_background_and_foreground(ppu_t *ptPPU)
                         ptPPU->cycle-1,                               //!< X
                         ptPPU->palette[color]);                       //!< 8bit color
 #else
-    ptPPU->video_frame_data[ptPPU->scanline * 256 + ptPPU->cycle - 1]
-            = ptPPU->palette[color];
+    ppu_store_pixel(ptPPU->video_frame_data, &ptPPU->tOutput, &ptPPU->tDirty,
+                    ptPPU->scanline, ptPPU->cycle - 1, color);
 
 #endif
 }
 
 
+//! \brief go to the next tile of the line, at the end of each fetched tile
+static inline void increment_coarse_x(ppu_caching_t *ppu)
+{
+    if (ppu->tVAddress.XScroll == 31) {
+        ppu->tVAddress.XToggleBit ^= 1;                                         //! switch to another name table horizontally
+    }
+    ppu->tVAddress.XScroll++;
+}
+
+//! \brief go to the next row of pixels, at dot 256 of a render line
+static inline void increment_y(ppu_caching_t *ppu)
+{
+    if (ppu->tVAddress.TileYOffsite == 7) {
+        if (ppu->tVAddress.YScroll == 29) {
+            ppu->tVAddress.YToggleBit ^= 1;                                     //! switch to another name table vertically
+            ppu->tVAddress.YScroll = 0;
+        } else {
+            ppu->tVAddress.YScroll++;
+        }
+    }
+    ppu->tVAddress.TileYOffsite++;
+}
+
+#if JEG_USE_SCANLINE_RENDERERS == ENABLED
+/*! \brief dots 1 to 256 of a visible line, exactly as the dot loop of ppu_update() does them
+ *! \note  chMask is a constant in every instance, so the PPUMASK tests of the
+ *!        pixel loop are resolved at compile time
+ */
+static JEG_ALWAYS_INLINE void render_visible_dots(ppu_caching_t *ppu, uint_fast8_t chMask)
+{
+    for (ppu->cycle = 1; ppu->cycle <= 256; ppu->cycle++) {
+        ppu_mix_background_and_foreground(ppu, chMask);
+        fetch_background_tile_info(ppu);
+        if (!(ppu->cycle & 0x07)) {
+            increment_coarse_x(ppu);
+        }
+    }
+    ppu->cycle = 256;
+    increment_y(ppu);
+}
+
+//! \brief one renderer per combination of the PPUMASK bits 1-4 (left column clip, background, sprites)
+#define RENDER_LINE_TEMPLATE(__BITS)                                            \
+    static void render_line_##__BITS(ppu_caching_t *ppu)                        \
+    {                                                                           \
+        render_visible_dots(ppu, (__BITS) << 1);                                \
+    }
+
+RENDER_LINE_TEMPLATE(0)     RENDER_LINE_TEMPLATE(1)     RENDER_LINE_TEMPLATE(2)     RENDER_LINE_TEMPLATE(3)
+RENDER_LINE_TEMPLATE(4)     RENDER_LINE_TEMPLATE(5)     RENDER_LINE_TEMPLATE(6)     RENDER_LINE_TEMPLATE(7)
+RENDER_LINE_TEMPLATE(8)     RENDER_LINE_TEMPLATE(9)     RENDER_LINE_TEMPLATE(10)    RENDER_LINE_TEMPLATE(11)
+RENDER_LINE_TEMPLATE(12)    RENDER_LINE_TEMPLATE(13)    RENDER_LINE_TEMPLATE(14)    RENDER_LINE_TEMPLATE(15)
+
+static ppu_caching_render_line_func_t * const line_renderers[16] = {
+    render_line_0,  render_line_1,  render_line_2,  render_line_3,
+    render_line_4,  render_line_5,  render_line_6,  render_line_7,
+    render_line_8,  render_line_9,  render_line_10, render_line_11,
+    render_line_12, render_line_13, render_line_14, render_line_15,
+};
+
+//! \brief PPUMASK was written, select the renderer of its configuration
+static void select_line_renderer(ppu_caching_t *ppu)
+{
+    ppu->fnRenderLine = line_renderers[(ppu->ppumask >> 1) & 0x0F];
+}
+#endif
+
 #define RENDERING_ENABLED       (ppu->ppumask & (   PPUMASK_SHOW_BACKGROUND     \
                                                 |   PPUMASK_SHOW_SPRITES))
 #define PRE_LINE                (261 == ppu->scanline)
@@ -780,26 +790,81 @@ static void ppu_mix_background_and_foreground(ppu_t *ptPPU)
 #define VISIBLE_CYCLE           (ppu->cycle >= 1 && ppu->cycle <= 256)
 #define FETCH_CYCLE             (PRE_FETCH_CYCLE || VISIBLE_CYCLE)
 
-uint_fast32_t ppu_update(ppu_t *ppu)
+/*! \brief a logged write to $2000, $2001, $2005 or $2006 takes effect
+ *! \note  called by ppu_update() when the ppu reached the cpu cycle of the write
+ */
+static void write_register(ppu_caching_t *ppu, uint_fast8_t chRegister, uint_fast8_t chData)
 {
-    //! tick
-    int_fast32_t cycles = (ppu->nes->cpu.cycle_number - ppu->last_cycle_number) * 3;
-    ppu->last_cycle_number = ppu->nes->cpu.cycle_number;
+    switch (chRegister) {
+        case 0: {
+            uint_fast8_t chOld = ppu->ppuctrl;
 
+            ppu->ppuctrl=chData;
+            ppu->t = (ppu->t & 0xF3FF) | ((chData & 0x03) <<10 );               //! select name/attribute tables
+        #if JEG_USE_BACKGROUND_BUFFERING == ENABLED
+            if ((chOld ^ chData) & PPUCTRL_BACKGROUND_TABLE) {
+                update_background(ppu);                                         //!< the other pattern table for the rest of the frame
+            }
+        #else
+            (void)chOld;
+        #endif
+            break;
+        }
+        case 1:
+            ppu->ppumask=chData;
+            ppu_pixel_update_mask(&ppu->tOutput, ppu->palette, chData);
+        #if JEG_USE_SCANLINE_RENDERERS == ENABLED
+            select_line_renderer(ppu);
+        #endif
+            break;
+        case 5:
+            if (0 == ppu->w) {
+                ppu->t = ( ppu->t & 0xFFE0 ) | ( chData>>3 );
+                ppu->x = chData & 0x07;
+                ppu->w = 1;
+            } else {
+                ppu->t = (ppu->t & 0x8FFF) | ((chData&0x07)<<12);
+                ppu->t = (ppu->t & 0xFC1F) | ((chData&0xF8)<<2);
+                ppu->w = 0;
+            }
+            break;
+        case 6:
+            if (0 == ppu->w) {
+                ppu->t = (ppu->t&0x80FF) | ((chData&0x3F)<<8);
+                ppu->w = 1;
+            } else {
+                ppu->t = (ppu->t&0xFF00) | chData;
+                ppu->v = ppu->t;
+                ppu->w = 0;
+            }
+            break;
+    }
+}
 
-#if JEG_USE_BACKGROUND_BUFFERING == ENABLED
-    update_background(ppu);
-#endif
-#if JEG_USE_SPRITE_BUFFER == ENABLED
-    update_sprite_buffer(ppu);
-#endif
-#if JEG_USE_OPTIMIZED_SPRITE_PROCESSING == ENABLED
-    //! initialise sprite Y order sort list
-    sort_sprite_order_list(ppu);
-#endif
+//! \brief run the ppu for the given number of dots
+static void ppu_run(ppu_caching_t *ppu, int_fast32_t cycles)
+{
+    while(cycles > 0) {
+        //! dots without any work are skipped in one go (VBlank, rendering disabled)
+        int_fast32_t nSkipped = ppu_skip_idle_dots(&ppu->cycle, &ppu->scanline, cycles, RENDERING_ENABLED);
+        if (nSkipped) {
+            cycles -= nSkipped;
+            continue;
+        }
 
+#if JEG_USE_SCANLINE_RENDERERS == ENABLED
+        //! the visible part of a line is drawn in one go when no update ends within it
+        if (    0 == ppu->cycle
+            &&  VISIBLE_LINE
+            &&  RENDERING_ENABLED
+            &&  cycles >= 256) {
+            ppu->fnRenderLine(ppu);
+            cycles -= 256;
+            continue;
+        }
+#endif
+        cycles--;
 
-    while(cycles--) {
         ppu->cycle++;                                                           //!< go to next pixel
 
         if (ppu->cycle > 340) {                                                 //!< if scanline is rendered go to next scanline
@@ -817,7 +882,7 @@ uint_fast32_t ppu_update(ppu_t *ppu)
 
             //! background logic
             if (VISIBLE_LINE && VISIBLE_CYCLE) {
-                ppu_mix_background_and_foreground(ppu);
+                ppu_mix_background_and_foreground(ppu, ppu->ppumask);
             }
 
 
@@ -865,25 +930,11 @@ uint_fast32_t ppu_update(ppu_t *ppu)
 
                 if (    FETCH_CYCLE
                     &&  ((ppu->cycle & 0x07) == 0) ) {
-
-                    if (ppu->tVAddress.XScroll == 31) {
-                        ppu->tVAddress.XToggleBit ^= 1;                         //! switch to another name table horizontally
-                    }
-                    ppu->tVAddress.XScroll++;
+                    increment_coarse_x(ppu);
                 }
 
                 if (256 == ppu->cycle) {
-
-                    if (ppu->tVAddress.TileYOffsite == 7) {
-                        if (ppu->tVAddress.YScroll == 29) {
-                            ppu->tVAddress.YToggleBit ^= 1;                     //! switch to another name table vertically
-                            ppu->tVAddress.YScroll = 0;
-                        } else {
-                            ppu->tVAddress.YScroll++;
-                        }
-                    }
-                    ppu->tVAddress.TileYOffsite++;
-
+                    increment_y(ppu);
                 } else if (ppu->cycle == 257) {
                     /* equivalent logic
                     ppu->tVAddress.XScroll = ppu->tTempVAddress.XScroll;
@@ -900,9 +951,6 @@ uint_fast32_t ppu_update(ppu_t *ppu)
                     /*! fetch all the sprite informations on current scanline */
                     ppu->sprite_count = fetch_sprite_info_on_specified_line(ppu, ppu->scanline);
 
-                } else if (240 == ppu->scanline) {
-                    //! reset sprite Y order list counter
-                    ppu->SpriteYOrderList.chCurrent = 0;
                 } else {
                     ppu->sprite_count = 0;
                 }
@@ -928,12 +976,39 @@ uint_fast32_t ppu_update(ppu_t *ppu)
                                 |   PPUSTATUS_SPRITE_OVERFLOW);
         }
     }
+}
+
+//! \brief run the ppu up to the cpu cycle dwCycle
+static void ppu_catch_up(ppu_caching_t *ppu, uint_fast64_t dwCycle)
+{
+    ppu_run(ppu, (dwCycle - ppu->last_cycle_number) * 3);
+    ppu->last_cycle_number = dwCycle;
+}
+
+static uint_fast32_t ppu_update(nes_t *ptNES)
+{
+    ppu_caching_t *ppu = ptNES->ppu.internal;
+
+#if JEG_USE_BACKGROUND_BUFFERING == ENABLED
+    update_background(ppu);
+#endif
+#if JEG_USE_SPRITE_BUFFER == ENABLED
+    update_sprite_buffer(ppu);
+#endif
+
+    //! replay the logged register writes on the dots they were made on
+    for (uint_fast8_t n = 0; n < ppu->tRegisterLog.chCount; n++) {
+        ppu_catch_up(ppu, ppu->tRegisterLog.tWrite[n].dwCycle);
+        write_register(ppu, ppu->tRegisterLog.tWrite[n].chRegister, ppu->tRegisterLog.tWrite[n].chValue);
+    }
+    ppu->tRegisterLog.chCount = 0;
+    ppu_catch_up(ppu, ptNES->cpu.cycle_number);
 
     return (341*262-((ppu->scanline+21)%262)*341-ppu->cycle)/3+1;
 }
 
 #if JEG_USE_FRAME_SYNC_UP_FLAG  == ENABLED
-bool ppu_is_frame_ready(ppu_t *ptPPU)
+bool ppu_caching_is_frame_ready(ppu_caching_t *ptPPU)
 {
     bool bResult = ptPPU->bFrameReady;
     ptPPU->bFrameReady = false;
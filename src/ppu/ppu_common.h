@@ -0,0 +1,216 @@
+#ifndef PPU_COMMON_H
+#define PPU_COMMON_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "nes.h"
+#include "jeg_cfg.h"
+
+//! \name PPU Control Register bit mask
+//! @{
+#define PPUCTRL_NAMETABLE                   (3<<0)
+#define PPUCTRL_INCREMENT                   (1<<2)
+#define PPUCTRL_SPRITE_TABLE                (1<<3)
+#define PPUCTRL_BACKGROUND_TABLE            (1<<4)
+#define PPUCTRL_SPRITE_SIZE                 (1<<5)
+#define PPUCTRL_MASTER_SLAVE                (1<<6)
+#define PPUCTRL_NMI                         (1<<7)
+//! @}
+
+//! \name PPU Masking Register Bit Mask
+//! @{
+#define PPUMASK_GRAYSCALE                   (1<<0)
+#define PPUMASK_SHOW_LEFT_BACKGROUND        (1<<1)
+#define PPUMASK_SHOW_LEFT_SPRITES           (1<<2)
+#define PPUMASK_SHOW_BACKGROUND             (1<<3)
+#define PPUMASK_SHOW_SPRITES                (1<<4)
+#define PPUMASK_RED_TINT                    (1<<5)
+#define PPUMASK_GREEN_TINT                  (1<<6)
+#define PPUMASK_BLUE_TINT                   (1<<7)
+//! @}
+
+//! \name register bits deciding which pattern table addresses the PPU fetches
+//! @{
+#define PPUCTRL_PATTERN_FETCH               (PPUCTRL_SPRITE_TABLE | PPUCTRL_BACKGROUND_TABLE | PPUCTRL_SPRITE_SIZE)
+#define PPUMASK_PATTERN_FETCH               (PPUMASK_SHOW_BACKGROUND | PPUMASK_SHOW_SPRITES)
+//! @}
+
+//! \name PPU status register bit mask
+//! @{
+#define PPUSTATUS_SPRITE_OVERFLOW           (1<<5)
+#define PPUSTATUS_SPRITE_ZERO_HIT           (1<<6)
+#define PPUSTATUS_VBLANK                    (1<<7)
+//! @}
+
+typedef void ppu_draw_pixel_func_t(void *, uint_fast8_t , uint_fast8_t , uint_fast8_t );
+
+typedef union {
+    uint8_t chValue;
+    struct {
+        uint8_t Low     : 4;
+        uint8_t High    : 4;
+    };
+} compact_dual_pixels_t;
+
+typedef uint8_t nes_screen_buffer_t[240][256];
+
+//! \brief one bit per line of the picture (bit n%32 of word n/32 for line n)
+#define PPU_DIRTY_LINE_WORDS                ((240 + 31) / 32)
+
+//! \brief parts of the picture changed since the host cleared them (see ppu_clear_dirty_lines())
+typedef struct {
+    uint32_t wLines[PPU_DIRTY_LINE_WORDS];                                      //!< bit per line
+    uint32_t wBlocks[240 / 8];                                                  //!< bit n of word m: 8x8 block at (8n, 8m)
+} ppu_dirty_t;
+
+
+typedef struct {
+    uint_fast16_t   XScroll     : 5;
+    uint_fast16_t   YScroll     : 5;
+    uint_fast16_t   XToggleBit  : 1;
+    uint_fast16_t   YToggleBit  : 1;
+    uint_fast16_t   TileYOffsite: 3;
+} vram_addr_t;
+
+typedef union {
+    struct {
+        uint8_t chY;
+        uint8_t chIndex;
+        union {
+            struct {
+                uint8_t         ColorH              : 2;
+                uint8_t                             : 3;
+                uint8_t         Priority            : 1;
+                uint8_t         IsFlipHorizontally  : 1;
+                uint8_t         IsFlipVertically    : 1;
+            };
+            uint8_t chValue;
+        }Attributes;
+        uint8_t chPosition;
+    };
+    uint32_t wValue;
+}sprite_t;
+
+typedef union {
+    uint8_t     chBuffer[256];
+    sprite_t    SpriteInfo[64];
+} sprite_table_t;
+
+//! \brief copy the 256 byte of an OAM DMA into the OAM, starting at the current oam address
+static inline void ppu_oam_dma_copy(uint8_t *pchOAM, uint_fast8_t chOAMAddress, const uint8_t *pchData)
+{
+    memcpy(&pchOAM[chOAMAddress], pchData, 256 - chOAMAddress);
+    memcpy(pchOAM, &pchData[256 - chOAMAddress], chOAMAddress);
+}
+
+/*! \brief tell the cartridge how the PPU fetches pattern data from now on
+ *! \note  the PPU is only updated on demand, the actual position is derived
+ *!        from the position of the last update and the passed cpu cycles
+ */
+static inline void ppu_report_pattern_fetch(nes_t *ptNES, uint_fast64_t dwLastCycle,
+                                            uint_fast32_t wScanline, uint_fast32_t wCycle,
+                                            uint_fast8_t chPPUCtrl, uint_fast8_t chPPUMask)
+{
+    uint_fast64_t dwCycle = ptNES->cpu.cycle_number;
+
+    ptNES->cartridge.ppu_setup( ptNES->cartridge.internal, dwCycle,
+                                (wScanline * 341 + wCycle + (dwCycle - dwLastCycle) * 3) % (341 * 262),
+                                chPPUCtrl, chPPUMask);
+}
+
+//! \brief number of register writes the PPU keeps before it has to catch up
+#define PPU_REGISTER_LOG_SIZE               32
+
+//! \brief a write to $2000, $2001, $2005 or $2006 waiting for the PPU to reach its cpu cycle
+typedef struct {
+    uint64_t dwCycle;                                                           //!< cpu cycle of the write
+    uint8_t chRegister;                                                         //!< register number (0-7)
+    uint8_t chValue;
+} ppu_register_write_t;
+
+/*! \brief the register writes since the last update of the PPU, in the order they were made
+ *! \note  the PPU renders in batches (catch-up), the writes are replayed on the dots
+ *!        they were made on, so mid-frame changes of scroll, pattern tables or PPUMASK
+ *!        don't need an update of the PPU on every write
+ */
+typedef struct {
+    ppu_register_write_t tWrite[PPU_REGISTER_LOG_SIZE];
+    uint_fast8_t chCount;
+} ppu_register_log_t;
+
+//! \brief the value of a register once all logged writes are replayed
+static inline uint_fast8_t ppu_register_log_latest(const ppu_register_log_t *ptLog, uint_fast8_t chRegister,
+                                                   uint_fast8_t chValue)
+{
+    for (uint_fast8_t n = ptLog->chCount; n > 0; n--) {
+        if (ptLog->tWrite[n - 1].chRegister == chRegister) {
+            return ptLog->tWrite[n - 1].chValue;
+        }
+    }
+    return chValue;
+}
+
+//! \brief add a write to the log, the caller has to replay the log first if it is full
+static inline void ppu_register_log_push(ppu_register_log_t *ptLog, uint_fast64_t dwCycle,
+                                         uint_fast8_t chRegister, uint_fast8_t chValue)
+{
+    ppu_register_write_t *ptWrite = &ptLog->tWrite[ptLog->chCount++];
+
+    ptWrite->dwCycle    = dwCycle;
+    ptWrite->chRegister = chRegister;
+    ptWrite->chValue    = chValue;
+}
+
+//! \name dots of a frame (scanline * 341 + cycle) the PPU acts on although it renders nothing
+//! @{
+#define PPU_DOTS_PER_FRAME                  (341 * 262)
+#define PPU_DOT_VBLANK_SET                  (241 * 341 + 1)
+#define PPU_DOT_VBLANK_CLEAR                (260 * 341 + 329)
+#define PPU_DOT_IDLE_FIRST                  (240 * 341 + 258)                   //!< first dot after the last sprite evaluation
+#define PPU_DOT_IDLE_LAST                   (261 * 341)                         //!< last dot before the pre-render fetches
+//! @}
+
+/*! \brief skip the dots following the current position which have no effect at all
+ *! \note  without rendering only the VBlank set/clear dots and the start of a
+ *!        frame (odd/even flag) have to be processed, with rendering the dots
+ *!        between the sprite evaluation of line 240 and the pre-render line
+ *!        are idle except for the VBlank dots. The position stops on the dot
+ *!        before the next one that needs work, which the caller then processes.
+ *! \return the number of skipped dots (at most nDots)
+ */
+static inline int_fast32_t ppu_skip_idle_dots(int_fast32_t *pnCycle, uint_fast16_t *phwScanline,
+                                              int_fast32_t nDots, bool bRendering)
+{
+    uint_fast32_t wDot, wNext = PPU_DOTS_PER_FRAME;                             //!< first dot which needs work
+
+    if (bRendering && (*phwScanline < 240 || *phwScanline > 260)) {
+        return 0;                                                               //!< the common case, checked first
+    }
+    wDot = *phwScanline * 341 + *pnCycle;
+    if (bRendering) {
+        if (wDot + 1 < PPU_DOT_IDLE_FIRST || wDot + 1 > PPU_DOT_IDLE_LAST) {
+            return 0;
+        }
+        wNext = PPU_DOT_IDLE_LAST + 1;
+    }
+    if (wDot < PPU_DOT_VBLANK_SET && PPU_DOT_VBLANK_SET < wNext) {
+        wNext = PPU_DOT_VBLANK_SET;
+    }
+    if (wDot < PPU_DOT_VBLANK_CLEAR && PPU_DOT_VBLANK_CLEAR < wNext) {
+        wNext = PPU_DOT_VBLANK_CLEAR;
+    }
+
+    if ((int_fast32_t)(wNext - wDot - 1) < nDots) {
+        nDots = wNext - wDot - 1;
+    }
+    if (nDots > 0) {
+        wDot += nDots;
+        *phwScanline = wDot / 341;
+        *pnCycle = wDot % 341;
+    }
+    return nDots;
+}
+
+#endif
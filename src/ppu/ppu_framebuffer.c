@@ -1,49 +1,20 @@
 #include "ppu_framebuffer.h"
+#include "ppu_tile_decode.h"
 #include "nes.h"
 
 #include <string.h>
 
-//! \name PPU Control Register bit mask
-//! @{
-#define PPUCTRL_NAMETABLE                   (3<<0)
-#define PPUCTRL_INCREMENT                   (1<<2)
-#define PPUCTRL_SPRITE_TABLE                (1<<3)
-#define PPUCTRL_BACKGROUND_TABLE            (1<<4)
-#define PPUCTRL_SPRITE_SIZE                 (1<<5)
-#define PPUCTRL_MASTER_SLAVE                (1<<6)
-#define PPUCTRL_NMI                         (1<<7)
-//! @}
-
-//! \name PPU Masking Register Bit Mask
-//! @{
-#define PPUMASK_GRAYSCALE                   (1<<0)
-#define PPUMASK_SHOW_LEFT_BACKGROUND        (1<<1)
-#define PPUMASK_SHOW_LEFT_SPRITES           (1<<2)
-#define PPUMASK_SHOW_BACKGROUND             (1<<3)
-#define PPUMASK_SHOW_SPRITES                (1<<4)
-#define PPUMASK_RED_TINT                    (1<<5)
-#define PPUMASK_GREEN_TINT                  (1<<6)
-#define PPUMASK_BLUE_TINT                   (1<<7)
-//! @}
-
-//! \name PPU status register bit mask
-//! @{
-#define PPUSTATUS_SPRITE_OVERFLOW           (1<<5)
-#define PPUSTATUS_SPRITE_ZERO_HIT           (1<<6)
-#define PPUSTATUS_VBLANK                    (1<<7)
-//! @}
-
 static void ppu_reset(nes_t *nes);
 static uint_fast8_t ppu_read(nes_t *ptNES, uint_fast16_t hwAddress);
 static void ppu_write(nes_t *ptNES, uint_fast16_t hwAddress, uint_fast8_t chData);
 static void ppu_write_dma(nes_t *nes, uint8_t *data);
 static uint_fast32_t ppu_update(nes_t *ptNES);
 
-void ppu_init(nes_t *nes, ppu_t *ppu, uint8_t *video_frame_data)
+void ppu_framebuffer_init(nes_t *nes, ppu_framebuffer_t *ppu, uint8_t *video_frame_data)
 {
     nes->ppu.internal = ppu;
     ppu->video_frame_data = video_frame_data;
-    memset(ppu->video_frame_data, 0, 256*240);
+    ppu->tOutput.chFormat = PPU_PIXEL_INDEX;
     ppu_reset(nes);
     nes->ppu.read = ppu_read;
     nes->ppu.write = ppu_write;
@@ -54,9 +25,10 @@ void ppu_init(nes_t *nes, ppu_t *ppu, uint8_t *video_frame_data)
 
 static void ppu_reset(nes_t *nes)
 {
-    ppu_t *ppu=nes->ppu.internal;
+    ppu_framebuffer_t *ppu=nes->ppu.internal;
 
     ppu->last_cycle_number  = 0;
+    ppu->tRegisterLog.chCount = 0;
     ppu->cycle              = 340;
     ppu->scanline           = 240;
     ppu->ppuctrl            = 0;
@@ -66,7 +38,12 @@ static void ppu_reset(nes_t *nes)
     ppu->oam_address        = 0;
     ppu->register_data      = 0;
     ppu->name_table_byte    = 0;
-    memset(ppu->video_frame_data, 0, 256*240);
+#if JEG_USE_OPTIMIZED_SPRITE_PROCESSING == ENABLED
+    ppu->tSpriteIndex.chHeight = 0;                                             //!< built on the first use
+#endif
+    ppu_pixel_setup(&ppu->tOutput, (ppu_pixel_format_t)ppu->tOutput.chFormat, ppu->palette, ppu->ppumask);
+    ppu_pixel_clear(&ppu->tOutput, ppu->video_frame_data);
+    memset(&ppu->tDirty, 0xFF, sizeof(ppu->tDirty));                           //!< the host has to show the cleared picture
 }
 
 static uint_fast8_t ppu_bus_read(nes_t *nes, uint_fast16_t address);
@@ -76,7 +53,7 @@ static uint_fast8_t ppu_read(nes_t *ptNES, uint_fast16_t hwAddress)
 {
     int value, buffered;
 
-    ppu_t *ppu=ptNES->ppu.internal;
+    ppu_framebuffer_t *ppu=ptNES->ppu.internal;
 
     switch (hwAddress & 0x07) {
         case 2:
@@ -95,6 +72,7 @@ static uint_fast8_t ppu_read(nes_t *ptNES, uint_fast16_t hwAddress)
             break;
 
         case 7:
+            ppu_update(ptNES);
             value=ppu_bus_read(ptNES, ppu->v);
             if ((ppu->v & 0x3FFF) < 0x3F00) {
                 buffered=ppu->buffered_data;
@@ -115,52 +93,63 @@ static uint_fast8_t ppu_read(nes_t *ptNES, uint_fast16_t hwAddress)
 }
 
 static void ppu_write_dma(nes_t *nes, uint8_t *data) {
-    ppu_t *ppu=nes->ppu.internal;
-    memcpy(&ppu->tSpriteTable.chBuffer[ppu->oam_address], data, 256);
+    ppu_framebuffer_t *ppu=nes->ppu.internal;
+    ppu_oam_dma_copy(ppu->tSpriteTable.chBuffer, ppu->oam_address & 0xFF, data);
+#if JEG_USE_OPTIMIZED_SPRITE_PROCESSING == ENABLED
+    ppu_sprite_index_update(&ppu->tSpriteIndex, &ppu->tSpriteTable);
+#endif
+}
+
+/*! \brief log a write to $2000, $2001, $2005 or $2006, see write_register()
+ *! \note  the cartridge is told about a new pattern fetch configuration right
+ *!        away, it follows the cpu and not the (late) ppu
+ */
+static void log_register_write(nes_t *ptNES, uint_fast8_t chRegister, uint_fast8_t chData)
+{
+    ppu_framebuffer_t *ppu=ptNES->ppu.internal;
+    uint_fast8_t chPPUCtrl, chPPUMask;
+
+    if (PPU_REGISTER_LOG_SIZE == ppu->tRegisterLog.chCount) {
+        ppu_update(ptNES);
+    }
+
+    chPPUCtrl = ppu_register_log_latest(&ppu->tRegisterLog, 0, ppu->ppuctrl);
+    chPPUMask = ppu_register_log_latest(&ppu->tRegisterLog, 1, ppu->ppumask);
+    if (    (0 == chRegister && ((chPPUCtrl ^ chData) & PPUCTRL_PATTERN_FETCH))
+        ||  (1 == chRegister && ((chPPUMask ^ chData) & PPUMASK_PATTERN_FETCH))) {
+        ppu_report_pattern_fetch(ptNES, ppu->last_cycle_number, ppu->scanline, ppu->cycle,
+                                 0 == chRegister ? chData : chPPUCtrl,
+                                 1 == chRegister ? chData : chPPUMask);
+    }
+
+    ppu_register_log_push(&ppu->tRegisterLog, ptNES->cpu.cycle_number, chRegister, chData);
 }
 
 static void ppu_write(nes_t *ptNES, uint_fast16_t hwAddress, uint_fast8_t chData)
 {
-    ppu_t *ppu=ptNES->ppu.internal;
+    ppu_framebuffer_t *ppu=ptNES->ppu.internal;
     ppu->register_data = chData;
 
     switch (hwAddress & 7) {
         case 0:
-            ppu->ppuctrl=chData;
-            ppu->t = (ppu->t & 0xF3FF) | ((chData & 0x03) <<10 );
-            break;
         case 1:
-            ppu->ppumask=chData;
+        case 5:
+        case 6:
+            log_register_write(ptNES, hwAddress & 7, chData);
             break;
         case 3:
             ppu->oam_address=chData;
             break;
         case 4:
-            ppu->tSpriteTable.chBuffer[ppu->oam_address++] = chData;
-            break;
-        case 5:
-            ppu_update(ptNES);
-            if (0 == ppu->w) {
-                ppu->t = ( ppu->t & 0xFFE0 ) | ( chData>>3 );
-                ppu->x = chData & 0x07;
-                ppu->w = 1;
-            } else {
-                ppu->t = (ppu->t & 0x8FFF) | ((chData&0x07)<<12);
-                ppu->t = (ppu->t & 0xFC1F) | ((chData&0xF8)<<2);
-                ppu->w = 0;
-            }
-            break;
-        case 6:
-            if (0 == ppu->w) {
-                ppu->t = (ppu->t&0x80FF) | ((chData&0x3F)<<8);
-                ppu->w = 1;
-            } else {
-                ppu->t = (ppu->t&0xFF00) | chData;
-                ppu->v = ppu->t;
-                ppu->w = 0;
+#if JEG_USE_OPTIMIZED_SPRITE_PROCESSING == ENABLED
+            if (!(ppu->oam_address & 0x03)) {
+                ppu_sprite_index_move(&ppu->tSpriteIndex, ppu->oam_address >> 2, chData);
             }
+#endif
+            ppu->tSpriteTable.chBuffer[ppu->oam_address++] = chData;
             break;
         case 7:
+            ppu_update(ptNES);                                                  //!< v and the vram as seen by the cpu
             ppu_bus_write(ptNES, ppu->v, chData);
             ppu->v += (0 == (ppu->ppuctrl & PPUCTRL_INCREMENT)) ? 1:32;
             break;
@@ -172,7 +161,7 @@ uint_fast8_t ppu_bus_read (nes_t *ptNES, uint_fast16_t hwAddress)
     uint_fast8_t chData;
     hwAddress &= 0x3FFF;
 
-    ppu_t *ppu=ptNES->ppu.internal;
+    ppu_framebuffer_t *ppu=ptNES->ppu.internal;
 
     if (hwAddress < 0x3F00) {
         chData = ptNES->cartridge.read_chr(ptNES->cartridge.internal, hwAddress);
@@ -191,7 +180,7 @@ void ppu_bus_write (nes_t *ptNES, uint_fast16_t hwAddress, uint_fast8_t chData)
 {
     hwAddress &= 0x3FFF;
 
-    ppu_t *ppu=ptNES->ppu.internal;
+    ppu_framebuffer_t *ppu=ptNES->ppu.internal;
 
     if (hwAddress<0x3F00) {
         ptNES->cartridge.write_chr(ptNES->cartridge.internal, hwAddress, chData);
@@ -201,12 +190,13 @@ void ppu_bus_write (nes_t *ptNES, uint_fast16_t hwAddress, uint_fast8_t chData)
             hwAddress-=16;
         }
         ppu->palette[hwAddress] = chData;
+        ppu_pixel_update_entry(&ppu->tOutput, hwAddress, chData);
     }
 }
 
 static uint32_t fetch_sprite_pattern(nes_t *ptNES, sprite_t *ptSpriteInfo, uint_fast16_t hwRow)
 {
-    ppu_t *ppu=ptNES->ppu.internal;
+    ppu_framebuffer_t *ppu=ptNES->ppu.internal;
 
     uint_fast8_t tile = ptSpriteInfo->chIndex;
     uint_fast8_t chAttributes =  ptSpriteInfo->Attributes.chValue;
@@ -233,33 +223,13 @@ static uint32_t fetch_sprite_pattern(nes_t *ptNES, sprite_t *ptSpriteInfo, uint_
 
     hwAddress = 0x1000 * table + tile * 16 + hwRow;
 
-    uint_fast8_t low_tile_byte = ppu_bus_read(ptNES, hwAddress);
-    uint_fast8_t high_tile_byte = ppu_bus_read(ptNES, hwAddress + 8);
-    uint32_t data=0;
-
-    uint_fast8_t p1, p2;
-    if (chAttributes & 0x40) {
-        uint_fast8_t n = 8;
-        do {
-            p1= (low_tile_byte & 0x01);
-            p2= (high_tile_byte & 0x01) << 1;
-            low_tile_byte >>= 1;
-            high_tile_byte >>= 1;
-
-            data <<= 4;
-            data |= ((chAttributes & 3) << 2) | p1 | p2;
-        } while(--n);
-    } else {
-        uint_fast8_t n = 8;
-        do {
-            p1 = (low_tile_byte & 0x80) >> 7;
-            p2 = (high_tile_byte & 0x80) >> 6;
-            low_tile_byte <<= 1;
-            high_tile_byte <<= 1;
-
-            data <<= 4;
-            data |= ((chAttributes & 3) << 2) | p1 | p2;
-        } while(--n);
+    uint32_t data = ppu_tile_decode_row(ppu_bus_read(ptNES, hwAddress),
+                                        ppu_bus_read(ptNES, hwAddress + 8),
+                                        (chAttributes & 3) << 2);
+
+    //! the leftmost pixel is expected in the lowest nibble
+    if (!(chAttributes & 0x40)) {
+        data = ppu_tile_mirror_row(data);
     }
 
     return data;
@@ -267,11 +237,32 @@ static uint32_t fetch_sprite_pattern(nes_t *ptNES, sprite_t *ptSpriteInfo, uint_
 
 static inline uint_fast8_t fetch_sprite_info_on_specified_line(nes_t *ptNES, uint_fast32_t nScanLine)
 {
-    ppu_t *ptPPU=ptNES->ppu.internal;
+    ppu_framebuffer_t *ptPPU=ptNES->ppu.internal;
 
     uint_fast8_t chCount = 0;
     uint_fast8_t chSpriteSize = ((ptPPU->ppuctrl & PPUCTRL_SPRITE_SIZE) ? 16 : 8);
 
+    memset(ptPPU->chSpriteLine, 0, sizeof(ptPPU->chSpriteLine));
+
+#if JEG_USE_OPTIMIZED_SPRITE_PROCESSING == ENABLED
+    //! the sprites of the line in OAM order, taken from the index
+    uint64_t dwSprites = ppu_sprite_index_line(&ptPPU->tSpriteIndex, &ptPPU->tSpriteTable, nScanLine, chSpriteSize);
+
+    if (ppu_sprite_count(dwSprites) > 8) {
+        ptPPU->ppustatus |= PPUSTATUS_SPRITE_OVERFLOW;
+    }
+    for (; dwSprites && chCount < JEG_MAX_ALLOWED_SPRITES_ON_SINGLE_SCANLINE; dwSprites &= dwSprites - 1) {
+        uint_fast8_t j = ppu_sprite_first(dwSprites);
+        sprite_t *ptSprite = &ptPPU->tSpriteTable.SpriteInfo[j];
+
+        ppu_sprite_line_draw(ptPPU->chSpriteLine, fetch_sprite_pattern(ptNES, ptSprite, nScanLine - ptSprite->chY),
+                             ptSprite->chPosition, ppu_sprite_line_flags(ptSprite, j));
+        chCount++;
+    }
+    return chCount;
+#else
+    uint_fast8_t chInRange = 0;
+
     // evaluate sprite
     for(int_fast32_t j = 0; j < 64; j++) {
         int_fast32_t row = ptPPU->scanline-ptPPU->tSpriteTable.SpriteInfo[j].chY;
@@ -279,52 +270,35 @@ static inline uint_fast8_t fetch_sprite_info_on_specified_line(nes_t *ptNES, uin
             ||  (row >= chSpriteSize)) {
             continue;
         }
+        chInRange++;
         if (chCount < JEG_MAX_ALLOWED_SPRITES_ON_SINGLE_SCANLINE) {
-            ptPPU->sprite_patterns[chCount]   = fetch_sprite_pattern(ptNES, ptPPU->tSpriteTable.SpriteInfo + j, row);
-            ptPPU->sprite_positions[chCount]  = ptPPU->tSpriteTable.SpriteInfo[j].chPosition;
-            ptPPU->sprite_priorities[chCount] = ptPPU->tSpriteTable.SpriteInfo[j].Attributes.Priority;
-            ptPPU->sprite_indicies[chCount]   = j;
+            sprite_t *ptSprite = &ptPPU->tSpriteTable.SpriteInfo[j];
+
+            ppu_sprite_line_draw(ptPPU->chSpriteLine, fetch_sprite_pattern(ptNES, ptSprite, row),
+                                 ptSprite->chPosition, ppu_sprite_line_flags(ptSprite, j));
             chCount++;
         }
     }
 
-    if (chCount > 8) {
+    if (chInRange > 8) {
         ptPPU->ppustatus |= PPUSTATUS_SPRITE_OVERFLOW;
     }
     return chCount;
+#endif
 }
 
 static void ppu_mix_background_and_foreground(nes_t *ptNES)
 {
-    ppu_t *ptPPU=ptNES->ppu.internal;
+    ppu_framebuffer_t *ptPPU=ptNES->ppu.internal;
 
     //! render pixel
-    uint_fast8_t background = 0, i = 0, sprite = 0;
-
-    //! get sprite pixel color
-    if (ptPPU->ppumask & PPUMASK_SHOW_SPRITES) {
-
-        for(uint_fast8_t j = 0; j < ptPPU->sprite_count; j++) {
-            int_fast16_t offset =   (ptPPU->cycle - 1)
-                                  - (int_fast16_t)ptPPU->sprite_positions[j];
-
-            if ( offset < 0 || offset > 7) {
-                continue;
-            }
-
-            int_fast32_t color = (ptPPU->sprite_patterns[j] >> ((7 - offset) * 4)) & 0x0F;
-            if (!(color & 0x03)) {
-                continue;
-            }
+    uint_fast8_t background = 0, sprite = 0, color = 0;
 
-            i = j;
-            sprite = color;
-            break;
-        }
+    //! get sprite pixel color, rasterized for the whole line at the sprite evaluation
+    if (ptPPU->sprite_count && (ptPPU->ppumask & PPUMASK_SHOW_SPRITES)) {
+        sprite = ptPPU->chSpriteLine[ptPPU->cycle - 1];
     }
 
-    uint_fast8_t s = (sprite & 0x03), color = 0;
-
     //! get background pixel color
     if ((ptPPU->ppumask&PPUMASK_SHOW_BACKGROUND) != 0) {
         background = (ptPPU->tile_data >> (32 + ((7-ptPPU->x) * 4)) ) & 0x0F;
@@ -339,31 +313,25 @@ static void ppu_mix_background_and_foreground(nes_t *ptNES)
         }
     }
 
-    uint_fast8_t b = (background & 0x03);
-
-    if (!b && s) {
-        color = sprite | 0x10;
-    } else if (b && !s) {
+    if (!(background & 0x03)) {
+        color = sprite ? ((sprite & PPU_SPRITE_PIXEL_COLOR) | 0x10) : 0;
+    } else if (!sprite) {
         color = background;
-    } else if (b && s) {
-        if (    (ptPPU->sprite_indicies[i] == 0)
+    } else {
+        if (    (sprite & PPU_SPRITE_PIXEL_ZERO)
             &&  ((ptPPU->cycle - 1) < 255)) {
             ptPPU->ppustatus |= PPUSTATUS_SPRITE_ZERO_HIT;
         }
 
-        if (ptPPU->sprite_priorities[i] == 0) {
-            color = sprite | 0x10;
-        } else {
+        if (sprite & PPU_SPRITE_PIXEL_BEHIND) {
             color = background;
+        } else {
+            color = (sprite & PPU_SPRITE_PIXEL_COLOR) | 0x10;
         }
     }
 
-    if ( color >= 16 && !(color & 0x03)) {
-        color -= 16;
-    }
-
-    ptPPU->video_frame_data[ptPPU->scanline * 256 + ptPPU->cycle - 1]
-            = ptPPU->palette[color];
+    ppu_store_pixel(ptPPU->video_frame_data, &ptPPU->tOutput, &ptPPU->tDirty,
+                    ptPPU->scanline, ptPPU->cycle - 1, color);
 }
 
 
@@ -376,15 +344,58 @@ static void ppu_mix_background_and_foreground(nes_t *ptNES)
 #define VISIBLE_CYCLE           (ppu->cycle >= 1 && ppu->cycle <= 256)
 #define FETCH_CYCLE             (PRE_FETCH_CYCLE || VISIBLE_CYCLE)
 
-static uint_fast32_t ppu_update(nes_t *ptNES)
+/*! \brief a logged write to $2000, $2001, $2005 or $2006 takes effect
+ *! \note  called by ppu_update() when the ppu reached the cpu cycle of the write
+ */
+static void write_register(ppu_framebuffer_t *ppu, uint_fast8_t chRegister, uint_fast8_t chData)
+{
+    switch (chRegister) {
+        case 0:
+            ppu->ppuctrl=chData;
+            ppu->t = (ppu->t & 0xF3FF) | ((chData & 0x03) <<10 );
+            break;
+        case 1:
+            ppu->ppumask=chData;
+            ppu_pixel_update_mask(&ppu->tOutput, ppu->palette, chData);
+            break;
+        case 5:
+            if (0 == ppu->w) {
+                ppu->t = ( ppu->t & 0xFFE0 ) | ( chData>>3 );
+                ppu->x = chData & 0x07;
+                ppu->w = 1;
+            } else {
+                ppu->t = (ppu->t & 0x8FFF) | ((chData&0x07)<<12);
+                ppu->t = (ppu->t & 0xFC1F) | ((chData&0xF8)<<2);
+                ppu->w = 0;
+            }
+            break;
+        case 6:
+            if (0 == ppu->w) {
+                ppu->t = (ppu->t&0x80FF) | ((chData&0x3F)<<8);
+                ppu->w = 1;
+            } else {
+                ppu->t = (ppu->t&0xFF00) | chData;
+                ppu->v = ppu->t;
+                ppu->w = 0;
+            }
+            break;
+    }
+}
+
+//! \brief run the ppu for the given number of dots
+static void ppu_run(nes_t *ptNES, int_fast32_t cycles)
 {
-    ppu_t *ppu=ptNES->ppu.internal;
+    ppu_framebuffer_t *ppu=ptNES->ppu.internal;
 
-    //! tick
-    int_fast32_t cycles = (ptNES->cpu.cycle_number - ppu->last_cycle_number) * 3;
-    ppu->last_cycle_number = ptNES->cpu.cycle_number;
+    while(cycles > 0) {
+        //! dots without any work are skipped in one go (VBlank, rendering disabled)
+        int_fast32_t nSkipped = ppu_skip_idle_dots(&ppu->cycle, &ppu->scanline, cycles, RENDERING_ENABLED);
+        if (nSkipped) {
+            cycles -= nSkipped;
+            continue;
+        }
+        cycles--;
 
-    while(cycles--) {
         ppu->cycle++;                                                           //!< go to next pixel
 
         if (ppu->cycle > 340) {                                                 //!< if scanline is rendered go to next scanline
@@ -407,7 +418,6 @@ static uint_fast32_t ppu_update(nes_t *ptNES)
 
             if (RENDER_LINE && FETCH_CYCLE) {
                 //! fetch background tile information with ppu->v
-                 uint32_t data=0;
                 ppu->tile_data<<=4;
                 switch (ppu->cycle%8) {
                     case 1: // fetch name table byte
@@ -423,13 +433,7 @@ static uint_fast32_t ppu_update(nes_t *ptNES)
                     ppu->high_tile_byte=ppu_bus_read(ptNES, 0x1000*(ppu->ppuctrl&PPUCTRL_BACKGROUND_TABLE?1:0)+ppu->name_table_byte*16+((ppu->v>>12)&7)+8);
                     break;
                     case 0: // store tile data
-                    for(int j=0; j<8; j++) {
-                        data<<=4;
-                        data|=ppu->attribute_table_byte|((ppu->low_tile_byte&0x80)>>7)|((ppu->high_tile_byte&0x80)>>6);
-                        ppu->low_tile_byte<<=1;
-                        ppu->high_tile_byte<<=1;
-                    }
-                    ppu->tile_data|=data;
+                    ppu->tile_data|=ppu_tile_decode_row(ppu->low_tile_byte, ppu->high_tile_byte, ppu->attribute_table_byte);
                     break;
                 }
             }
@@ -506,10 +510,6 @@ static uint_fast32_t ppu_update(nes_t *ptNES)
                     /*! fetch all the sprite informations on current scanline */
                     ppu->sprite_count = fetch_sprite_info_on_specified_line(ptNES, ppu->scanline);
 
-                } else if (240 == ppu->scanline) {
-                    //! reset sprite Y order list counter
-                    ppu->SpriteYOrderList.chCurrent = 0;
-
                 } else {
                     ppu->sprite_count = 0;
                 }
@@ -531,6 +531,28 @@ static uint_fast32_t ppu_update(nes_t *ptNES)
                                 |   PPUSTATUS_SPRITE_OVERFLOW);
         }
     }
+}
+
+//! \brief run the ppu up to the cpu cycle dwCycle
+static void ppu_catch_up(nes_t *ptNES, uint_fast64_t dwCycle)
+{
+    ppu_framebuffer_t *ppu=ptNES->ppu.internal;
+
+    ppu_run(ptNES, (dwCycle - ppu->last_cycle_number) * 3);
+    ppu->last_cycle_number = dwCycle;
+}
+
+static uint_fast32_t ppu_update(nes_t *ptNES)
+{
+    ppu_framebuffer_t *ppu=ptNES->ppu.internal;
+
+    //! replay the logged register writes on the dots they were made on
+    for (uint_fast8_t n = 0; n < ppu->tRegisterLog.chCount; n++) {
+        ppu_catch_up(ptNES, ppu->tRegisterLog.tWrite[n].dwCycle);
+        write_register(ppu, ppu->tRegisterLog.tWrite[n].chRegister, ppu->tRegisterLog.tWrite[n].chValue);
+    }
+    ppu->tRegisterLog.chCount = 0;
+    ppu_catch_up(ptNES, ptNES->cpu.cycle_number);
 
     return (341*262-((ppu->scanline+21)%262)*341-ppu->cycle)/3+1;
 }
@@ -0,0 +1,106 @@
+#include "ppu_pixel.h"
+
+const uint32_t ppu_rgb_palette[64] = {
+    0x7C7C7C, 0x0000FC, 0x0000BC, 0x4428BC, 0x940084, 0xA80020, 0xA81000, 0x881400,
+    0x503000, 0x007800, 0x006800, 0x005800, 0x004058, 0x000000, 0x000000, 0x000000,
+    0xBCBCBC, 0x0078F8, 0x0058F8, 0x6844FC, 0xD800CC, 0xE40058, 0xF83800, 0xE45C10,
+    0xAC7C00, 0x00B800, 0x00A800, 0x00A844, 0x008888, 0x000000, 0x000000, 0x000000,
+    0xF8F8F8, 0x3CBCFC, 0x6888FC, 0x9878F8, 0xF878F8, 0xF85898, 0xF87858, 0xFCA044,
+    0xF8B800, 0xB8F818, 0x58D854, 0x58F898, 0x00E8D8, 0x787878, 0x000000, 0x000000,
+    0xFCFCFC, 0xA4E4FC, 0xB8B8F8, 0xD8B8F8, 0xF8B8F8, 0xF8A4C0, 0xF0D0B0, 0xFCE0A8,
+    0xF8D878, 0xD8F878, 0xB8F8B8, 0xB8F8D8, 0x00FCFC, 0xF8D8F8, 0x000000, 0x000000
+};
+
+static const uint8_t pixel_sizes[PPU_PIXEL_FORMAT_COUNT] = {
+    [PPU_PIXEL_INDEX]       = 1,
+    [PPU_PIXEL_RGB565]      = 2,
+    [PPU_PIXEL_ARGB8888]    = 4,
+    [PPU_PIXEL_RGB888]      = 3,
+};
+
+uint_fast8_t ppu_pixel_size(ppu_pixel_format_t tFormat)
+{
+    if (tFormat >= PPU_PIXEL_FORMAT_COUNT) {
+        return 0;
+    }
+    return pixel_sizes[tFormat];
+}
+
+uint32_t ppu_pixel_convert(ppu_pixel_format_t tFormat, uint_fast8_t chPPUMask, uint_fast8_t chValue)
+{
+    uint32_t wRed, wGreen, wBlue;
+
+    if (PPU_PIXEL_INDEX == tFormat) {
+        return chValue;
+    }
+
+    if (chPPUMask & PPUMASK_GRAYSCALE) {
+        chValue &= 0x30;
+    }
+    wRed    = (ppu_rgb_palette[chValue & 0x3F] >> 16) & 0xFF;
+    wGreen  = (ppu_rgb_palette[chValue & 0x3F] >> 8) & 0xFF;
+    wBlue   = ppu_rgb_palette[chValue & 0x3F] & 0xFF;
+
+    //! an emphasized color darkens the other two (NTSC bit order)
+    if (chPPUMask & PPUMASK_RED_TINT) {
+        wGreen  = wGreen * 3 / 4;
+        wBlue   = wBlue * 3 / 4;
+    }
+    if (chPPUMask & PPUMASK_GREEN_TINT) {
+        wRed    = wRed * 3 / 4;
+        wBlue   = wBlue * 3 / 4;
+    }
+    if (chPPUMask & PPUMASK_BLUE_TINT) {
+        wRed    = wRed * 3 / 4;
+        wGreen  = wGreen * 3 / 4;
+    }
+
+    switch (tFormat) {
+        case PPU_PIXEL_RGB565:
+            return ((wRed >> 3) << 11) | ((wGreen >> 2) << 5) | (wBlue >> 3);
+        case PPU_PIXEL_ARGB8888:
+            return 0xFF000000 | (wRed << 16) | (wGreen << 8) | wBlue;
+        default:
+            return (wRed << 16) | (wGreen << 8) | wBlue;
+    }
+}
+
+void ppu_pixel_setup(ppu_pixel_output_t *ptOutput, ppu_pixel_format_t tFormat,
+                     const uint_fast8_t *pchPalette, uint_fast8_t chPPUMask)
+{
+    ptOutput->chFormat  = tFormat;
+    ptOutput->chSize    = ppu_pixel_size(tFormat);
+    ptOutput->chMask    = chPPUMask & PPUMASK_COLOR;
+
+    for (uint_fast8_t n = 0; n < 32; n++) {
+        ptOutput->wColor[n] = ppu_pixel_convert(tFormat, chPPUMask, pchPalette[n]);
+    }
+}
+
+void ppu_pixel_clear(const ppu_pixel_output_t *ptOutput, uint8_t *pchFrame)
+{
+    uint32_t wColor = ppu_pixel_convert((ppu_pixel_format_t)ptOutput->chFormat, ptOutput->chMask, 0);
+
+    if (PPU_PIXEL_INDEX == ptOutput->chFormat) {
+        memset(pchFrame, wColor, 256 * 240);
+        return;
+    }
+    for (uint_fast32_t n = 0; n < 256 * 240 * ptOutput->chSize; n += ptOutput->chSize) {
+        if (PPU_PIXEL_RGB888 == ptOutput->chFormat) {
+            pchFrame[n]     = wColor >> 16;
+            pchFrame[n + 1] = wColor >> 8;
+            pchFrame[n + 2] = wColor;
+        } else if (PPU_PIXEL_RGB565 == ptOutput->chFormat) {
+            uint16_t hwColor = (uint16_t)wColor;
+            memcpy(&pchFrame[n], &hwColor, 2);
+        } else {
+            memcpy(&pchFrame[n], &wColor, 4);
+        }
+    }
+}
+
+void ppu_pixel_update_entry(ppu_pixel_output_t *ptOutput, uint_fast8_t chEntry, uint_fast8_t chValue)
+{
+    ptOutput->wColor[chEntry & 0x1F] = ppu_pixel_convert((ppu_pixel_format_t)ptOutput->chFormat,
+                                                         ptOutput->chMask, chValue);
+}
@@ -0,0 +1,107 @@
+#ifndef PPU_PIXEL_H
+#define PPU_PIXEL_H
+
+#include <stdint.h>
+#include <string.h>
+#include "ppu_common.h"
+#include "jeg_cfg.h"
+
+//! \brief formats of the picture written by the ppu
+typedef enum {
+    PPU_PIXEL_INDEX             = 0,                                            //!< palette RAM value, one byte (default)
+    PPU_PIXEL_RGB565,                                                           //!< 16 bit, native byte order
+    PPU_PIXEL_ARGB8888,                                                         //!< 32 bit, native byte order, alpha 0xFF
+    PPU_PIXEL_RGB888,                                                           //!< three bytes: red, green, blue
+    PPU_PIXEL_FORMAT_COUNT,
+} ppu_pixel_format_t;
+
+//! \brief PPUMASK bits changing the colors of the picture (not applied to PPU_PIXEL_INDEX)
+#define PPUMASK_COLOR                       (   PPUMASK_GRAYSCALE | PPUMASK_RED_TINT    \
+                                            |   PPUMASK_GREEN_TINT | PPUMASK_BLUE_TINT)
+
+/*! \brief the host pixel of every palette RAM entry
+ *! \note  kept up to date on writes to $3F00-$3F1F and to the color bits of PPUMASK,
+ *!        so drawing a pixel is one look up
+ */
+typedef struct {
+    uint32_t wColor[32];
+    uint8_t chFormat;                                                           //!< ppu_pixel_format_t
+    uint8_t chSize;                                                             //!< bytes per pixel
+    uint8_t chMask;                                                             //!< PPUMASK_COLOR bits wColor is made for
+} ppu_pixel_output_t;
+
+//! \brief colors of the 64 palette values (0xRRGGBB)
+extern const uint32_t ppu_rgb_palette[64];
+
+//! \brief bytes per pixel of a format, 0 for an unknown format
+extern uint_fast8_t ppu_pixel_size(ppu_pixel_format_t tFormat);
+
+//! \brief host pixel of a palette value with the grayscale and emphasis bits of PPUMASK applied
+extern uint32_t ppu_pixel_convert(ppu_pixel_format_t tFormat, uint_fast8_t chPPUMask, uint_fast8_t chValue);
+
+//! \brief select the format and convert all entries of the palette RAM
+extern void ppu_pixel_setup(ppu_pixel_output_t *ptOutput, ppu_pixel_format_t tFormat,
+                            const uint_fast8_t *pchPalette, uint_fast8_t chPPUMask);
+
+//! \brief fill a picture with palette value 0, as after power up
+extern void ppu_pixel_clear(const ppu_pixel_output_t *ptOutput, uint8_t *pchFrame);
+
+//! \brief a palette RAM entry was written
+extern void ppu_pixel_update_entry(ppu_pixel_output_t *ptOutput, uint_fast8_t chEntry,
+                                   uint_fast8_t chValue);
+
+//! \brief PPUMASK was written, all entries are converted again if its color bits changed
+static inline void ppu_pixel_update_mask(ppu_pixel_output_t *ptOutput, const uint_fast8_t *pchPalette,
+                                         uint_fast8_t chPPUMask)
+{
+    if ((chPPUMask & PPUMASK_COLOR) != ptOutput->chMask) {
+        ppu_pixel_setup(ptOutput, (ppu_pixel_format_t)ptOutput->chFormat, pchPalette, chPPUMask);
+    }
+}
+
+/*! \brief store a host pixel (see ppu_pixel_convert()) and mark its line and 8x8 block dirty if it changed
+ *! \note  branch free apart from the format, the compare costs less than a mispredicted jump per pixel
+ */
+static inline void ppu_store_color(uint8_t *pchFrame, const ppu_pixel_output_t *ptOutput, ppu_dirty_t *ptDirty,
+                                   uint_fast16_t hwLine, uint_fast16_t hwX, uint32_t wColor)
+{
+    uint32_t wOld, wChanged;
+    uint8_t *pchPixel = &pchFrame[(hwLine * 256 + hwX) * ptOutput->chSize];
+
+    switch (ptOutput->chFormat) {
+        case PPU_PIXEL_RGB565: {
+            uint16_t hwPixel, hwColor = (uint16_t)wColor;
+            memcpy(&hwPixel, pchPixel, 2);
+            memcpy(pchPixel, &hwColor, 2);
+            wOld = hwPixel;
+            break;
+        }
+        case PPU_PIXEL_ARGB8888:
+            memcpy(&wOld, pchPixel, 4);
+            memcpy(pchPixel, &wColor, 4);
+            break;
+        case PPU_PIXEL_RGB888:
+            wOld = ((uint32_t)pchPixel[0] << 16) | ((uint32_t)pchPixel[1] << 8) | pchPixel[2];
+            pchPixel[0] = wColor >> 16;
+            pchPixel[1] = wColor >> 8;
+            pchPixel[2] = wColor;
+            break;
+        default:
+            wOld = *pchPixel;
+            *pchPixel = wColor;
+            break;
+    }
+
+    wChanged = (wOld != wColor);
+    ptDirty->wLines[hwLine >> 5] |= wChanged << (hwLine & 0x1F);
+    ptDirty->wBlocks[hwLine >> 3] |= wChanged << (hwX >> 3);
+}
+
+//! \brief store the pixel of a palette RAM entry (see ppu_store_color())
+static inline void ppu_store_pixel(uint8_t *pchFrame, const ppu_pixel_output_t *ptOutput, ppu_dirty_t *ptDirty,
+                                   uint_fast16_t hwLine, uint_fast16_t hwX, uint_fast8_t chEntry)
+{
+    ppu_store_color(pchFrame, ptOutput, ptDirty, hwLine, hwX, ptOutput->wColor[chEntry]);
+}
+
+#endif
@@ -0,0 +1,49 @@
+#include <string.h>
+#include "ppu_sprite.h"
+
+//! \brief set or clear the bit of a sprite on the lines it covers
+static void mark_lines(ppu_sprite_index_t *ptIndex, uint_fast8_t chSprite, bool bSet)
+{
+    uint64_t dwBit = (uint64_t)1 << chSprite;
+    uint_fast16_t hwLine = ptIndex->chY[chSprite];
+    uint_fast16_t hwEnd = hwLine + ptIndex->chHeight;
+
+    if (hwEnd > 240) {
+        hwEnd = 240;
+    }
+    for (; hwLine < hwEnd; hwLine++) {
+        if (bSet) {
+            ptIndex->dwLine[hwLine] |= dwBit;
+        } else {
+            ptIndex->dwLine[hwLine] &= ~dwBit;
+        }
+    }
+}
+
+void ppu_sprite_index_build(ppu_sprite_index_t *ptIndex, const sprite_table_t *ptTable, uint_fast8_t chHeight)
+{
+    memset(ptIndex->dwLine, 0, sizeof(ptIndex->dwLine));
+    ptIndex->chHeight = chHeight;
+
+    for (uint_fast8_t n = 0; n < 64; n++) {
+        ptIndex->chY[n] = ptTable->SpriteInfo[n].chY;
+        mark_lines(ptIndex, n, true);
+    }
+}
+
+void ppu_sprite_index_move(ppu_sprite_index_t *ptIndex, uint_fast8_t chSprite, uint_fast8_t chY)
+{
+    if (ptIndex->chY[chSprite] == chY) {
+        return;
+    }
+    mark_lines(ptIndex, chSprite, false);
+    ptIndex->chY[chSprite] = chY;
+    mark_lines(ptIndex, chSprite, true);
+}
+
+void ppu_sprite_index_update(ppu_sprite_index_t *ptIndex, const sprite_table_t *ptTable)
+{
+    for (uint_fast8_t n = 0; n < 64; n++) {
+        ppu_sprite_index_move(ptIndex, n, ptTable->SpriteInfo[n].chY);
+    }
+}
@@ -0,0 +1,106 @@
+#ifndef PPU_SPRITE_H
+#define PPU_SPRITE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ppu_common.h"
+#include "jeg_cfg.h"
+
+/*! \brief the sprites on every line of the picture: bit n of a line is set if sprite n covers it
+ *! \note  the lowest bit is the sprite with the highest priority (OAM order), so the evaluation
+ *!        of a line takes the lowest bits and the overflow flag is a bit count.
+ *!        The index follows the Y coordinates in OAM, a write moves one sprite.
+ */
+typedef struct {
+    uint64_t dwLine[240];
+    uint8_t chY[64];                                                            //!< Y of every sprite in the index
+    uint8_t chHeight;                                                           //!< sprite height of the index, 0: not built
+} ppu_sprite_index_t;
+
+//! \brief build the index from scratch for the given sprite height (8 or 16)
+extern void ppu_sprite_index_build(ppu_sprite_index_t *ptIndex, const sprite_table_t *ptTable, uint_fast8_t chHeight);
+
+//! \brief sprite chSprite got the Y coordinate chY (e.g. by a write to OAMDATA)
+extern void ppu_sprite_index_move(ppu_sprite_index_t *ptIndex, uint_fast8_t chSprite, uint_fast8_t chY);
+
+//! \brief move all sprites whose Y coordinate changed in OAM (e.g. after an OAM DMA)
+extern void ppu_sprite_index_update(ppu_sprite_index_t *ptIndex, const sprite_table_t *ptTable);
+
+//! \brief sprites covering a line (bit n for sprite n), the index is rebuilt if the sprite height changed
+static inline uint64_t ppu_sprite_index_line(ppu_sprite_index_t *ptIndex, const sprite_table_t *ptTable,
+                                             uint_fast16_t hwLine, uint_fast8_t chHeight)
+{
+    if (ptIndex->chHeight != chHeight) {
+        ppu_sprite_index_build(ptIndex, ptTable, chHeight);
+    }
+    return ptIndex->dwLine[hwLine];
+}
+
+//! \brief number of the lowest set bit (dwSprites must not be 0)
+static inline uint_fast8_t ppu_sprite_first(uint64_t dwSprites)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(dwSprites);
+#else
+    uint_fast8_t chSprite = 0;
+
+    while (!(dwSprites & 1)) {
+        dwSprites >>= 1;
+        chSprite++;
+    }
+    return chSprite;
+#endif
+}
+
+//! \brief number of sprites on a line
+static inline uint_fast8_t ppu_sprite_count(uint64_t dwSprites)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(dwSprites);
+#else
+    uint_fast8_t chCount = 0;
+
+    for (; dwSprites; dwSprites &= dwSprites - 1) {
+        chCount++;
+    }
+    return chCount;
+#endif
+}
+
+/*! \name a pixel of the sprite line buffer (see ppu_sprite_line_draw())
+ *! \note  0 is a transparent pixel, every other value is an opaque sprite pixel
+ */
+//! @{
+#define PPU_SPRITE_PIXEL_COLOR              (0x0F)                              //!< palette bits and pattern bits
+#define PPU_SPRITE_PIXEL_BEHIND             (1<<6)                              //!< drawn behind the background
+#define PPU_SPRITE_PIXEL_ZERO               (1<<7)                              //!< pixel of sprite 0
+//! @}
+
+/*! \brief rasterize one row of a sprite into the 256 pixel line buffer
+ *! \param wPattern decoded row, the leftmost pixel in the lowest nibble
+ *! \param chFlags  PPU_SPRITE_PIXEL_BEHIND and PPU_SPRITE_PIXEL_ZERO of the sprite
+ *! \note  sprites are drawn in OAM order and never overwrite an opaque pixel,
+ *!        so every pixel holds the sprite with the highest priority
+ */
+static inline void ppu_sprite_line_draw(uint8_t *pchLine, uint32_t wPattern,
+                                        uint_fast16_t hwX, uint_fast8_t chFlags)
+{
+    uint_fast16_t hwEnd = (hwX > 256 - 8) ? 256 : hwX + 8;
+
+    for (; hwX < hwEnd; hwX++, wPattern >>= 4) {
+        uint_fast8_t chColor = wPattern & PPU_SPRITE_PIXEL_COLOR;
+
+        if ((chColor & 0x03) && !pchLine[hwX]) {
+            pchLine[hwX] = chColor | chFlags;
+        }
+    }
+}
+
+//! \brief flags of a sprite for ppu_sprite_line_draw()
+static inline uint_fast8_t ppu_sprite_line_flags(const sprite_t *ptSprite, uint_fast8_t chIndex)
+{
+    return  (ptSprite->Attributes.Priority ? PPU_SPRITE_PIXEL_BEHIND : 0)
+        |   (0 == chIndex ? PPU_SPRITE_PIXEL_ZERO : 0);
+}
+
+#endif
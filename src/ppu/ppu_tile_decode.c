@@ -0,0 +1,9 @@
+#include "ppu_tile_decode.h"
+
+#define SPREAD2(__N)    (__N), (__N) + 0x00000001, (__N) + 0x00000010, (__N) + 0x00000011
+#define SPREAD4(__N)    SPREAD2(__N), SPREAD2((__N) + 0x00000100), SPREAD2((__N) + 0x00001000), SPREAD2((__N) + 0x00001100)
+#define SPREAD6(__N)    SPREAD4(__N), SPREAD4((__N) + 0x00010000), SPREAD4((__N) + 0x00100000), SPREAD4((__N) + 0x00110000)
+
+const uint32_t ppu_tile_spread_lut[256] = {
+    SPREAD6(0x00000000), SPREAD6(0x01000000), SPREAD6(0x10000000), SPREAD6(0x11000000)
+};
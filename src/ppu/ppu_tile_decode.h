@@ -0,0 +1,53 @@
+#ifndef PPU_TILE_DECODE_H
+#define PPU_TILE_DECODE_H
+
+#include <stdint.h>
+#include "jeg_cfg.h"
+
+#if defined(__BMI2__)
+#   include <immintrin.h>
+#endif
+
+/*! \brief spread look up table: bit i of the index is moved to bit 4*i
+ *! \note  only used when neither PDEP nor the SWAR variant is selected
+ */
+extern const uint32_t ppu_tile_spread_lut[256];
+
+//! \brief move bit i of a bitplane byte to the lowest bit of nibble i
+static inline uint32_t ppu_tile_spread(uint_fast8_t chPlane)
+{
+#if defined(__BMI2__)
+    return _pdep_u32(chPlane, 0x11111111);
+#elif JEG_USE_TILE_DECODE_LUT == ENABLED
+    return ppu_tile_spread_lut[chPlane & 0xFF];
+#else
+    uint32_t wPlane = chPlane & 0xFF;
+
+    wPlane = (wPlane | (wPlane << 12)) & 0x000F000F;
+    wPlane = (wPlane | (wPlane << 6))  & 0x03030303;
+    wPlane = (wPlane | (wPlane << 3))  & 0x11111111;
+    return wPlane;
+#endif
+}
+
+/*! \brief decode one row of a tile (two bitplane bytes) into 8 nibble pixels
+ *! \param chAttribute the palette bits, already shifted to bit 2-3
+ *! \return nibble i holds the pixel of bit i, i.e. the leftmost pixel is in nibble 7
+ */
+static inline uint32_t ppu_tile_decode_row(uint_fast8_t chLow, uint_fast8_t chHigh, uint_fast8_t chAttribute)
+{
+    return      ppu_tile_spread(chLow)
+            |   (ppu_tile_spread(chHigh) << 1)
+            |   ((uint32_t)chAttribute * 0x11111111);
+}
+
+//! \brief reverse the nibble order of a decoded row (horizontal flip)
+static inline uint32_t ppu_tile_mirror_row(uint32_t wRow)
+{
+    wRow = (wRow >> 16) | (wRow << 16);
+    wRow = ((wRow >> 8) & 0x00FF00FF) | ((wRow & 0x00FF00FF) << 8);
+    wRow = ((wRow >> 4) & 0x0F0F0F0F) | ((wRow & 0x0F0F0F0F) << 4);
+    return wRow;
+}
+
+#endif
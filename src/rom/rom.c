@@ -0,0 +1,372 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#   include <fcntl.h>
+#   include <unistd.h>
+#   include <sys/mman.h>
+#endif
+#include "rom.h"
+#include "hash.h"
+#include "jeg_cfg.h"
+
+static const uint8_t rom_archive_signature[4] = {'J', 'R', 'A', 0x1A};
+
+//! all opened ROMs, newest first (so archive members are listed before their archive)
+static rom_t *rom_cache = NULL;
+
+static void put_u32(uint8_t *pchBuffer, uint_fast32_t wValue)
+{
+    pchBuffer[0] = wValue & 0xFF;
+    pchBuffer[1] = (wValue >> 8) & 0xFF;
+    pchBuffer[2] = (wValue >> 16) & 0xFF;
+    pchBuffer[3] = (wValue >> 24) & 0xFF;
+}
+
+static uint_fast32_t get_u32(const uint8_t *pchBuffer)
+{
+    return      pchBuffer[0]
+            |   (pchBuffer[1] << 8)
+            |   ((uint_fast32_t)pchBuffer[2] << 16)
+            |   ((uint_fast32_t)pchBuffer[3] << 24);
+}
+
+//! \brief map a file read-only, fall back to reading it where mmap is not available
+static bool load_file(const char *pchPath, uint_fast32_t wSize, uint8_t **ppchBuffer, bool *pbMapped)
+{
+#ifndef _WIN32
+    void *pMapping;
+    int hFile = open(pchPath, O_RDONLY);
+
+    if (hFile < 0) {
+        return false;
+    }
+    pMapping = mmap(NULL, wSize, PROT_READ, MAP_PRIVATE, hFile, 0);
+    close(hFile);                                                               //!< the mapping stays valid
+    if (MAP_FAILED == pMapping) {
+        return false;
+    }
+    *ppchBuffer = pMapping;
+    *pbMapped = true;
+    return true;
+#else
+    FILE *ptFile = fopen(pchPath, "rb");
+    uint8_t *pchBuffer;
+
+    if (NULL == ptFile) {
+        return false;
+    }
+    pchBuffer = malloc(wSize);
+    if (NULL == pchBuffer || fread(pchBuffer, 1, wSize, ptFile) != wSize) {
+        free(pchBuffer);
+        fclose(ptFile);
+        return false;
+    }
+    fclose(ptFile);
+    *ppchBuffer = pchBuffer;
+    *pbMapped = false;
+    return true;
+#endif
+}
+
+static void release_buffer(uint8_t *pchBuffer, uint_fast32_t wSize, bool bMapped)
+{
+    if (NULL == pchBuffer) {
+        return ;
+    }
+#ifndef _WIN32
+    if (bMapped) {
+        munmap(pchBuffer, wSize);
+        return ;
+    }
+#endif
+    free(pchBuffer);
+}
+
+//! \brief find an already opened ROM with the same content
+static rom_t *find_content(const uint8_t *pchData, uint_fast32_t wSize, uint_fast32_t wHash)
+{
+    for (rom_t *ptROM = rom_cache; NULL != ptROM; ptROM = ptROM->ptNext) {
+        if (    ptROM->wSize == wSize
+            &&  ptROM->wHash == wHash
+            &&  (ptROM->pchData == pchData || 0 == memcmp(ptROM->pchData, pchData, wSize))) {
+            return ptROM;
+        }
+    }
+    return NULL;
+}
+
+static rom_t *add_rom(const uint8_t *pchData, uint_fast32_t wSize, uint_fast32_t wHash)
+{
+    rom_t *ptROM = calloc(1, sizeof(rom_t));
+
+    if (NULL == ptROM) {
+        return NULL;
+    }
+    ptROM->pchData      = pchData;
+    ptROM->wSize        = wSize;
+    ptROM->wHash        = wHash;
+    ptROM->wReferences  = 1;
+    ptROM->ptNext       = rom_cache;
+    rom_cache           = ptROM;
+    return ptROM;
+}
+
+rom_err_t rom_open(const rom_t **pptROM, const char *pchPath)
+{
+    struct stat tStat;
+    rom_t *ptROM;
+    uint8_t *pchBuffer;
+    uint_fast32_t wSize, wHash;
+    bool bMapped;
+
+    if (NULL == pptROM || NULL == pchPath) {
+        return rom_err_illegal_pointer;
+    }
+
+    if (stat(pchPath, &tStat) || tStat.st_size <= 0 || (uint64_t)tStat.st_size > UINT32_MAX) {
+        return rom_err_io;
+    }
+    wSize = tStat.st_size;
+
+#ifndef _WIN32
+    //! the same file again: its content does not need to be touched
+    for (ptROM = rom_cache; NULL != ptROM; ptROM = ptROM->ptNext) {
+        if (    ptROM->bHasIdentity
+            &&  ptROM->dwDevice == (uint64_t)tStat.st_dev
+            &&  ptROM->dwInode == (uint64_t)tStat.st_ino
+            &&  ptROM->lModified == (int64_t)tStat.st_mtime
+            &&  ptROM->wSize == wSize) {
+            ptROM->wReferences++;
+            *pptROM = ptROM;
+            return rom_ok;
+        }
+    }
+#endif
+
+    if (!load_file(pchPath, wSize, &pchBuffer, &bMapped)) {
+        return rom_err_io;
+    }
+
+    //! a copy of an already opened ROM (e.g. another file name)
+    wHash = hash_crc32(HASH_CRC32_INIT, pchBuffer, wSize);
+    ptROM = find_content(pchBuffer, wSize, wHash);
+    if (NULL != ptROM) {
+        release_buffer(pchBuffer, wSize, bMapped);
+        ptROM->wReferences++;
+        *pptROM = ptROM;
+        return rom_ok;
+    }
+
+    ptROM = add_rom(pchBuffer, wSize, wHash);
+    if (NULL == ptROM) {
+        release_buffer(pchBuffer, wSize, bMapped);
+        return rom_err_out_of_memory;
+    }
+    ptROM->pchBuffer    = pchBuffer;
+    ptROM->bMapped      = bMapped;
+#ifndef _WIN32
+    ptROM->bHasIdentity = true;                                                 //!< inode numbers are meaningless on windows
+    ptROM->dwDevice     = tStat.st_dev;
+    ptROM->dwInode      = tStat.st_ino;
+    ptROM->lModified    = tStat.st_mtime;
+#endif
+
+    *pptROM = ptROM;
+    return rom_ok;
+}
+
+rom_err_t rom_open_memory(const rom_t **pptROM, const uint8_t *pchData, uint_fast32_t wSize)
+{
+    rom_t *ptROM;
+    uint_fast32_t wHash;
+
+    if (NULL == pptROM || NULL == pchData) {
+        return rom_err_illegal_pointer;
+    }
+
+    wHash = hash_crc32(HASH_CRC32_INIT, pchData, wSize);
+    ptROM = find_content(pchData, wSize, wHash);
+    if (NULL != ptROM) {
+        ptROM->wReferences++;
+    } else {
+        ptROM = add_rom(pchData, wSize, wHash);
+        if (NULL == ptROM) {
+            return rom_err_out_of_memory;
+        }
+    }
+
+    *pptROM = ptROM;
+    return rom_ok;
+}
+
+rom_err_t rom_open_archive(const rom_t **pptROM, const rom_t *ptArchive, const char *pchName)
+{
+    const uint8_t *pchArchive;
+    uint_fast32_t wCount, wSize;
+
+    if (NULL == pptROM || NULL == ptArchive || NULL == pchName) {
+        return rom_err_illegal_pointer;
+    }
+
+    pchArchive = ptArchive->pchData;
+    wSize = ptArchive->wSize;
+    if (    wSize < ROM_ARCHIVE_HEADER_SIZE
+        ||  memcmp(pchArchive, rom_archive_signature, 4)) {
+        return rom_err_invalid_archive;
+    }
+    wCount = get_u32(&pchArchive[4]);
+    if (wCount > (wSize - ROM_ARCHIVE_HEADER_SIZE) / ROM_ARCHIVE_ENTRY_SIZE) {
+        return rom_err_invalid_archive;
+    }
+
+    for (uint_fast32_t n = 0; n < wCount; n++) {
+        const uint8_t *pchEntry = &pchArchive[ROM_ARCHIVE_HEADER_SIZE + n * ROM_ARCHIVE_ENTRY_SIZE];
+        uint_fast32_t wOffset = get_u32(&pchEntry[0]);
+        uint_fast32_t wImageSize = get_u32(&pchEntry[4]);
+        uint_fast32_t wHash = get_u32(&pchEntry[8]);
+        uint_fast32_t wName = get_u32(&pchEntry[12]);
+        const uint8_t *pchImage;
+        rom_t *ptROM;
+
+        if (    wName >= wSize
+            ||  NULL == memchr(&pchArchive[wName], 0, wSize - wName)
+            ||  wOffset > wSize
+            ||  wImageSize > wSize - wOffset) {
+            return rom_err_invalid_archive;
+        }
+        if (strcmp((const char *)&pchArchive[wName], pchName)) {
+            continue;
+        }
+
+        //! the directory holds the crc32, so the image itself is not read here
+        pchImage = &pchArchive[wOffset];
+        ptROM = find_content(pchImage, wImageSize, wHash);
+        if (NULL != ptROM) {
+            ptROM->wReferences++;
+        } else {
+            ptROM = add_rom(pchImage, wImageSize, wHash);
+            if (NULL == ptROM) {
+                return rom_err_out_of_memory;
+            }
+            ptROM->ptContainer = (rom_t *)ptArchive;
+            ptROM->ptContainer->wReferences++;                                  //!< the archive has to stay mapped
+        }
+        *pptROM = ptROM;
+        return rom_ok;
+    }
+    return rom_err_not_found;
+}
+
+void rom_close(const rom_t *ptROM)
+{
+    if (NULL != ptROM && ptROM->wReferences > 0) {
+        ((rom_t *)ptROM)->wReferences--;
+    }
+}
+
+void rom_cache_clear(void)
+{
+    rom_t **pptROM = &rom_cache;
+
+    //! archive members are listed before their archive, so a single pass releases both
+    while (NULL != *pptROM) {
+        rom_t *ptROM = *pptROM;
+
+        if (ptROM->wReferences > 0) {
+            pptROM = &ptROM->ptNext;
+            continue;
+        }
+        *pptROM = ptROM->ptNext;
+        rom_close(ptROM->ptContainer);
+        release_buffer(ptROM->pchBuffer, ptROM->wSize, ptROM->bMapped);
+        free(ptROM);
+    }
+}
+
+rom_err_t rom_archive_create(const char *pchPath, const char * const *ppchFiles, uint_fast32_t wCount)
+{
+    const rom_t **pptROM;
+    const char **ppchName;
+    uint8_t chBuffer[ROM_ARCHIVE_ENTRY_SIZE];
+    uint_fast32_t wName, wOffset;
+    rom_err_t tResult = rom_ok;
+    FILE *ptFile;
+    uint_fast32_t n;
+
+    if (NULL == pchPath || (NULL == ppchFiles && wCount)) {
+        return rom_err_illegal_pointer;
+    }
+
+    pptROM = calloc(wCount + 1, sizeof(rom_t *));
+    ppchName = calloc(wCount + 1, sizeof(char *));
+    if (NULL == pptROM || NULL == ppchName) {
+        free(pptROM);
+        free(ppchName);
+        return rom_err_out_of_memory;
+    }
+
+    //! names are stored without the directory
+    for (n = 0; n < wCount && rom_ok == tResult; n++) {
+        const char *pchSeparator = strrchr(ppchFiles[n], '/');
+        const char *pchBackslash = strrchr(ppchFiles[n], '\\');
+
+        if (NULL != pchBackslash && (NULL == pchSeparator || pchBackslash > pchSeparator)) {
+            pchSeparator = pchBackslash;
+        }
+        ppchName[n] = (NULL != pchSeparator) ? pchSeparator + 1 : ppchFiles[n];
+        tResult = rom_open(&pptROM[n], ppchFiles[n]);
+    }
+
+    ptFile = (rom_ok == tResult) ? fopen(pchPath, "wb") : NULL;
+    if (rom_ok == tResult && NULL == ptFile) {
+        tResult = rom_err_io;
+    }
+
+    if (rom_ok == tResult) {
+        memcpy(chBuffer, rom_archive_signature, 4);
+        put_u32(&chBuffer[4], wCount);
+        if (fwrite(chBuffer, 1, ROM_ARCHIVE_HEADER_SIZE, ptFile) != ROM_ARCHIVE_HEADER_SIZE) {
+            tResult = rom_err_io;
+        }
+
+        //! directory, followed by all names and then all images
+        wName = ROM_ARCHIVE_HEADER_SIZE + wCount * ROM_ARCHIVE_ENTRY_SIZE;
+        wOffset = wName;
+        for (n = 0; n < wCount; n++) {
+            wOffset += strlen(ppchName[n]) + 1;
+        }
+        for (n = 0; n < wCount && rom_ok == tResult; n++) {
+            put_u32(&chBuffer[0], wOffset);
+            put_u32(&chBuffer[4], pptROM[n]->wSize);
+            put_u32(&chBuffer[8], pptROM[n]->wHash);
+            put_u32(&chBuffer[12], wName);
+            if (fwrite(chBuffer, 1, ROM_ARCHIVE_ENTRY_SIZE, ptFile) != ROM_ARCHIVE_ENTRY_SIZE) {
+                tResult = rom_err_io;
+            }
+            wName += strlen(ppchName[n]) + 1;
+            wOffset += pptROM[n]->wSize;
+        }
+        for (n = 0; n < wCount && rom_ok == tResult; n++) {
+            if (fwrite(ppchName[n], 1, strlen(ppchName[n]) + 1, ptFile) != strlen(ppchName[n]) + 1) {
+                tResult = rom_err_io;
+            }
+        }
+        for (n = 0; n < wCount && rom_ok == tResult; n++) {
+            if (fwrite(pptROM[n]->pchData, 1, pptROM[n]->wSize, ptFile) != pptROM[n]->wSize) {
+                tResult = rom_err_io;
+            }
+        }
+    }
+
+    if (NULL != ptFile && fclose(ptFile)) {
+        tResult = rom_err_io;
+    }
+    for (n = 0; n < wCount; n++) {
+        rom_close(pptROM[n]);
+    }
+    free(pptROM);
+    free(ppchName);
+    return tResult;
+}
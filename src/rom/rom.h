@@ -0,0 +1,75 @@
+#ifndef ROM_H
+#define ROM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "jeg_cfg.h"
+
+/*! \note ROM images are shared: a file is mapped read-only (or read once where
+ *!       mmap is not available) and kept in a process wide cache, keyed by the
+ *!       file identity and by the crc32 of the content. Opening the same ROM
+ *!       again (e.g. for many console instances) neither reads nor allocates.
+ *!       The image is handed to cartridge_init() directly and must not be
+ *!       written. The cache is not thread safe, open the ROMs before starting
+ *!       worker threads.
+ *!
+ *! \note ROM archive layout (all values little endian)
+ *!
+ *!     offset  size    content
+ *!     0       4       signature "JRA\x1A"
+ *!     4       4       number of ROMs (n)
+ *!     8       16*n    per ROM: offset of the image, size of the image, crc32
+ *!                     of the image, offset of the zero terminated name
+ *!     ...             names and images (offsets relative to the archive start)
+ */
+
+#define ROM_ARCHIVE_HEADER_SIZE             8
+#define ROM_ARCHIVE_ENTRY_SIZE              16
+
+typedef enum {
+    rom_err_out_of_memory       = -5,
+    rom_err_invalid_archive     = -4,
+    rom_err_not_found           = -3,
+    rom_err_io                  = -2,
+    rom_err_illegal_pointer     = -1,
+    rom_ok                      = 0,
+} rom_err_t;
+
+typedef struct rom_t {
+    const uint8_t  *pchData;                                                    //!< the ROM image (read only)
+    uint_fast32_t   wSize;
+    uint_fast32_t   wHash;                                                      //!< crc32 of the image, see movie_rom_hash()
+
+    //! \name cache internals
+    //! @{
+    struct rom_t   *ptNext;
+    struct rom_t   *ptContainer;                                                //!< archive the image is located in
+    uint_fast32_t   wReferences;
+    uint8_t        *pchBuffer;                                                  //!< mapping or allocation owned by this entry
+    bool            bMapped;
+    bool            bHasIdentity;
+    uint64_t        dwDevice;                                                   //!< file identity of a file backed entry
+    uint64_t        dwInode;
+    int64_t         lModified;
+    //! @}
+} rom_t;
+
+//! \brief open a ROM file (or an archive file)
+extern rom_err_t rom_open(const rom_t **pptROM, const char *pchPath);
+
+//! \brief register a ROM image in memory, it is not copied and has to stay valid
+extern rom_err_t rom_open_memory(const rom_t **pptROM, const uint8_t *pchData, uint_fast32_t wSize);
+
+//! \brief open a ROM located in an opened archive, without copying it
+extern rom_err_t rom_open_archive(const rom_t **pptROM, const rom_t *ptArchive, const char *pchName);
+
+//! \brief release a ROM; unreferenced ROMs stay cached until rom_cache_clear()
+extern void rom_close(const rom_t *ptROM);
+
+//! \brief unmap / free all ROMs which are not referenced anymore
+extern void rom_cache_clear(void);
+
+//! \brief write an archive containing the given ROM files (stored with their file name)
+extern rom_err_t rom_archive_create(const char *pchPath, const char * const *ppchFiles, uint_fast32_t wCount);
+
+#endif
@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#   include <fcntl.h>
+#   include <unistd.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#endif
+#include "save.h"
+#include "jeg_cfg.h"
+
+#ifndef _WIN32
+//! \brief map the file shared, it is extended (with zeros) to wSize bytes
+static bool map_file(save_t *ptSave, const char *pchPath)
+{
+    struct stat tStat;
+    void *pMapping;
+    int hFile = open(pchPath, O_RDWR | O_CREAT, 0644);
+
+    if (hFile < 0) {
+        return false;
+    }
+    if (    0 != fstat(hFile, &tStat)
+        ||  ((uint_fast32_t)tStat.st_size < ptSave->wSize && 0 != ftruncate(hFile, ptSave->wSize))) {
+        close(hFile);
+        return false;
+    }
+    pMapping = mmap(NULL, ptSave->wSize, PROT_READ | PROT_WRITE, MAP_SHARED, hFile, 0);
+    close(hFile);                                                               //!< the mapping stays valid
+    if (MAP_FAILED == pMapping) {
+        return false;
+    }
+    ptSave->pchData = pMapping;
+    ptSave->bMapped = true;
+    return true;
+}
+#endif
+
+static save_err_t write_file(save_t *ptSave)
+{
+    FILE *ptFile = fopen(ptSave->pchPath, "wb");
+    bool bWritten;
+
+    if (NULL == ptFile) {
+        return save_err_io;
+    }
+    bWritten = fwrite(ptSave->pchData, 1, ptSave->wSize, ptFile) == ptSave->wSize;
+    if (0 != fclose(ptFile) || !bWritten) {
+        return save_err_io;
+    }
+    memcpy(ptSave->pchShadow, ptSave->pchData, ptSave->wSize);
+    return save_ok;
+}
+
+static void release(save_t *ptSave)
+{
+#ifndef _WIN32
+    if (ptSave->bMapped) {
+        munmap(ptSave->pchData, ptSave->wSize);
+    } else
+#endif
+    {
+        free(ptSave->pchData);
+    }
+    free(ptSave->pchShadow);
+    free(ptSave->pchPath);
+    memset(ptSave, 0, sizeof(save_t));
+}
+
+save_err_t save_open(save_t *ptSave, const char *pchPath, uint_fast32_t wSize)
+{
+    FILE *ptFile;
+
+    if (NULL == ptSave || NULL == pchPath) {
+        return save_err_illegal_pointer;
+    }
+    memset(ptSave, 0, sizeof(save_t));
+    ptSave->wSize = wSize;
+
+#ifndef _WIN32
+    if (map_file(ptSave, pchPath)) {
+        return save_ok;
+    }
+#endif
+
+    ptSave->pchData = calloc(1, wSize);
+    ptSave->pchShadow = calloc(1, wSize);
+    ptSave->pchPath = malloc(strlen(pchPath) + 1);
+    if (NULL == ptSave->pchData || NULL == ptSave->pchShadow || NULL == ptSave->pchPath) {
+        release(ptSave);
+        return save_err_out_of_memory;
+    }
+    strcpy(ptSave->pchPath, pchPath);
+
+    ptFile = fopen(pchPath, "rb");
+    if (NULL != ptFile) {
+        //! a shorter file leaves the rest zeroed
+        if (fread(ptSave->pchData, 1, wSize, ptFile) < wSize && ferror(ptFile)) {
+            fclose(ptFile);
+            release(ptSave);
+            return save_err_io;
+        }
+        fclose(ptFile);
+        memcpy(ptSave->pchShadow, ptSave->pchData, wSize);
+        return save_ok;
+    }
+
+    //! create the file right away, so a missing directory is reported here
+    if (save_ok != write_file(ptSave)) {
+        release(ptSave);
+        return save_err_io;
+    }
+    return save_ok;
+}
+
+save_err_t save_check(save_t *ptSave)
+{
+    if (NULL == ptSave || NULL == ptSave->pchData) {
+        return save_err_illegal_pointer;
+    }
+    if (ptSave->bMapped || 0 == memcmp(ptSave->pchData, ptSave->pchShadow, ptSave->wSize)) {
+        return save_ok;
+    }
+    return write_file(ptSave);
+}
+
+save_err_t save_sync(save_t *ptSave)
+{
+    if (NULL == ptSave || NULL == ptSave->pchData) {
+        return save_err_illegal_pointer;
+    }
+#ifndef _WIN32
+    if (ptSave->bMapped) {
+        return (0 == msync(ptSave->pchData, ptSave->wSize, MS_SYNC)) ? save_ok : save_err_io;
+    }
+#endif
+    return save_check(ptSave);
+}
+
+void save_close(save_t *ptSave)
+{
+    if (NULL == ptSave || NULL == ptSave->pchData) {
+        return ;
+    }
+    save_sync(ptSave);
+    release(ptSave);
+}
@@ -0,0 +1,49 @@
+#ifndef SAVE_H
+#define SAVE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "jeg_cfg.h"
+
+/*! \note Battery backed RAM is kept in a save file which is mapped shared into
+ *!       memory and handed to cartridge_attach_battery_ram(). Every write of the
+ *!       game goes directly to the page cache, so the save survives a crash of
+ *!       the process without any copying per frame; save_sync() (msync) only has
+ *!       to be called at controlled points (reset, exit, ...) to get it to disk.
+ *!       Where mmap is not available, the file is read into memory and a shadow
+ *!       copy is compared by save_check(), which the host calls periodically
+ *!       (e.g. once a second); the file is only written if the RAM was changed.
+ */
+
+typedef enum {
+    save_err_out_of_memory      = -3,
+    save_err_io                 = -2,
+    save_err_illegal_pointer    = -1,
+    save_ok                     = 0,
+} save_err_t;
+
+typedef struct {
+    uint8_t        *pchData;                                                    //!< the battery backed RAM
+    uint_fast32_t   wSize;
+    bool            bMapped;
+
+    //! \name fallback without mmap
+    //! @{
+    char           *pchPath;
+    uint8_t        *pchShadow;                                                  //!< content of the file
+    //! @}
+} save_t;
+
+//! \brief open (or create) a save file of wSize bytes, a new file is zeroed
+extern save_err_t save_open(save_t *ptSave, const char *pchPath, uint_fast32_t wSize);
+
+//! \brief periodic dirty check, writes the file if the RAM was changed (fallback only)
+extern save_err_t save_check(save_t *ptSave);
+
+//! \brief flush the RAM to the disk
+extern save_err_t save_sync(save_t *ptSave);
+
+//! \brief flush and release the save file
+extern void save_close(save_t *ptSave);
+
+#endif
@@ -0,0 +1,330 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test_rom.h"
+#include "hash.h"
+
+// cartridge and mapper behaviour as seen by the games, checked on every ppu backend
+
+// MMC3 scanline irq: the handler switches the background CHR bank, the picture has to split at the irq line
+#define MMC3_IRQ_LATCH 100
+
+static const uint8_t mmc3_code[]={
+  0x78,                   // E000 SEI
+  0xD8,                   // E001 CLD
+  0xA2, 0xFF,             // E002 LDX #$FF
+  0x9A,                   // E004 TXS
+  0x2C, 0x02, 0x20,       // E005 BIT $2002     wait for two vblanks
+  0x10, 0xFB,             // E008 BPL $E005
+  0x2C, 0x02, 0x20,       // E00A BIT $2002
+  0x10, 0xFB,             // E00D BPL $E00A
+  0xA9, 0x3F,             // E00F LDA #$3F      palette 0x0F, 0x16, 0x2A
+  0x8D, 0x06, 0x20,       // E011 STA $2006
+  0xA9, 0x00,             // E014 LDA #$00
+  0x8D, 0x06, 0x20,       // E016 STA $2006
+  0xA9, 0x0F,             // E019 LDA #$0F
+  0x8D, 0x07, 0x20,       // E01B STA $2007
+  0xA9, 0x16,             // E01E LDA #$16
+  0x8D, 0x07, 0x20,       // E020 STA $2007
+  0xA9, 0x2A,             // E023 LDA #$2A
+  0x8D, 0x07, 0x20,       // E025 STA $2007
+  0xA9, 0x00,             // E028 LDA #$00      scroll 0, 0
+  0x8D, 0x05, 0x20,       // E02A STA $2005
+  0x8D, 0x05, 0x20,       // E02D STA $2005
+  0xA9, 0x88,             // E030 LDA #$88      nmi, sprites at 0x1000 (A12 rises at dot 260)
+  0x8D, 0x00, 0x20,       // E032 STA $2000
+  0xA9, 0x1E,             // E035 LDA #$1E      background and sprites
+  0x8D, 0x01, 0x20,       // E037 STA $2001
+  0x58,                   // E03A CLI
+  0x4C, 0x3B, 0xE0,       // E03B JMP $E03B
+  // nmi: R0 = 0 (tile 0 solid color 1), reload and enable the irq
+  0x48,                   // E03E PHA
+  0xA9, 0x00,             // E03F LDA #$00
+  0x8D, 0x00, 0x80,       // E041 STA $8000
+  0x8D, 0x01, 0x80,       // E044 STA $8001
+  0xA9, MMC3_IRQ_LATCH,   // E047 LDA #LATCH
+  0x8D, 0x00, 0xC0,       // E049 STA $C000
+  0x8D, 0x01, 0xC0,       // E04C STA $C001
+  0x8D, 0x01, 0xE0,       // E04F STA $E001
+  0x68,                   // E052 PLA
+  0x40,                   // E053 RTI
+  // irq: acknowledge, R0 = 2 (tile 0 solid color 2), count
+  0x48,                   // E054 PHA
+  0x8D, 0x00, 0xE0,       // E055 STA $E000
+  0xA9, 0x00,             // E058 LDA #$00
+  0x8D, 0x00, 0x80,       // E05A STA $8000
+  0xA9, 0x02,             // E05D LDA #$02
+  0x8D, 0x01, 0x80,       // E05F STA $8001
+  0xE6, 0x10,             // E062 INC $10
+  0x68,                   // E064 PLA
+  0x40,                   // E065 RTI
+};
+
+static void test_mmc3_irq(ppu_backend_t backend) {
+  const char *name=ppu_backend_name(backend);
+  test_rom_t rom;
+  console_t *console;
+  int line, x, wrong;
+
+  test_rom_init(&rom, 4, 0, 2, 1);
+  test_rom_code(&rom, 0xE000, mmc3_code, sizeof(mmc3_code));
+  test_rom_vectors(&rom, 0xE03E, 0xE000, 0xE054);
+  test_rom_solid_tile(&rom, 0x0000, 1);
+  test_rom_solid_tile(&rom, 0x0800, 2);
+
+  console=test_console_create(&rom, backend);
+  TEST_CHECK(console!=NULL, "[%s] mmc3: unable to create the console", name);
+  if (console==NULL) {
+    return;
+  }
+
+  for (int frame=0; frame<10; frame++) {
+    uint8_t irqs=console->tNES.ram_data[0x10];
+
+    nes_iterate_frame(&console->tNES);
+    if (frame<5) {
+      continue;
+    }
+    TEST_CHECK(console->tNES.ram_data[0x10]==(uint8_t)(irqs+1), "[%s] mmc3: %d irqs in frame %d", name,
+      (uint8_t)(console->tNES.ram_data[0x10]-irqs), frame);
+
+    // the counter is reloaded on the pre-render line and reaches 0 on line LATCH-1,
+    // the handler switches the bank at the start of line LATCH (after its first tiles are fetched)
+    wrong=0;
+    for (line=0; line<240; line++) {
+      for (x=(line==MMC3_IRQ_LATCH)?32:0; x<256; x++) {
+        wrong+=(console->chFrame[line*256+x]!=(line<MMC3_IRQ_LATCH?0x16:0x2A));
+      }
+    }
+    TEST_CHECK(wrong==0, "[%s] mmc3: %d pixels on the wrong side of the split at line %d in frame %d", name,
+      wrong, MMC3_IRQ_LATCH, frame);
+  }
+  free(console);
+}
+
+// four screen board: every name table has its own memory, the ppu has to show the one selected by PPUCTRL
+static const uint8_t four_screen_code[]={
+  0x78,                   // E000 SEI
+  0xD8,                   // E001 CLD
+  0xA2, 0xFF,             // E002 LDX #$FF
+  0x9A,                   // E004 TXS
+  0x2C, 0x02, 0x20,       // E005 BIT $2002     wait for two vblanks
+  0x10, 0xFB,             // E008 BPL $E005
+  0x2C, 0x02, 0x20,       // E00A BIT $2002
+  0x10, 0xFB,             // E00D BPL $E00A
+  0xA9, 0x3F,             // E00F LDA #$3F      palette 0x0F, 0x16, 0x2A, 0x12
+  0x8D, 0x06, 0x20,       // E011 STA $2006
+  0xA9, 0x00,             // E014 LDA #$00
+  0x8D, 0x06, 0x20,       // E016 STA $2006
+  0xA2, 0x00,             // E019 LDX #$00
+  0xBD, 0x80, 0xE0,       // E01B LDA $E080,X
+  0x8D, 0x07, 0x20,       // E01E STA $2007
+  0xE8,                   // E021 INX
+  0xE0, 0x04,             // E022 CPX #$04
+  0xD0, 0xF5,             // E024 BNE $E01B
+  0xA0, 0x00,             // E026 LDY #$00      row 0 of name table Y: tile (Y+1)&3
+  0xB9, 0x84, 0xE0,       // E028 LDA $E084,Y
+  0x8D, 0x06, 0x20,       // E02B STA $2006
+  0xA9, 0x00,             // E02E LDA #$00
+  0x8D, 0x06, 0x20,       // E030 STA $2006
+  0xB9, 0x88, 0xE0,       // E033 LDA $E088,Y
+  0xA2, 0x20,             // E036 LDX #$20
+  0x8D, 0x07, 0x20,       // E038 STA $2007
+  0xCA,                   // E03B DEX
+  0xD0, 0xFA,             // E03C BNE $E038
+  0xC8,                   // E03E INY
+  0xC0, 0x04,             // E03F CPY #$04
+  0xD0, 0xE5,             // E041 BNE $E028
+  0xA0, 0x00,             // E043 LDY #$00      read the first tile of every name table back to $20+Y
+  0xB9, 0x84, 0xE0,       // E045 LDA $E084,Y
+  0x8D, 0x06, 0x20,       // E048 STA $2006
+  0xA9, 0x00,             // E04B LDA #$00
+  0x8D, 0x06, 0x20,       // E04D STA $2006
+  0xAD, 0x07, 0x20,       // E050 LDA $2007     buffered read
+  0xAD, 0x07, 0x20,       // E053 LDA $2007
+  0x99, 0x20, 0x00,       // E056 STA $0020,Y
+  0xC8,                   // E059 INY
+  0xC0, 0x04,             // E05A CPY #$04
+  0xD0, 0xE7,             // E05C BNE $E045
+  0xA9, 0x80,             // E05E LDA #$80      nmi
+  0x8D, 0x00, 0x20,       // E060 STA $2000
+  0xA9, 0x0A,             // E063 LDA #$0A      background
+  0x8D, 0x01, 0x20,       // E065 STA $2001
+  0x4C, 0x68, 0xE0,       // E068 JMP $E068
+  // nmi: show the name table in $30
+  0x48,                   // E06B PHA
+  0xA5, 0x30,             // E06C LDA $30
+  0x09, 0x80,             // E06E ORA #$80
+  0x8D, 0x00, 0x20,       // E070 STA $2000
+  0x2C, 0x02, 0x20,       // E073 BIT $2002
+  0xA9, 0x00,             // E076 LDA #$00
+  0x8D, 0x05, 0x20,       // E078 STA $2005
+  0x8D, 0x05, 0x20,       // E07B STA $2005
+  0x68,                   // E07E PLA
+  0x40,                   // E07F RTI
+  0x0F, 0x16, 0x2A, 0x12, // E080 palette
+  0x20, 0x24, 0x28, 0x2C, // E084 name table addresses
+  0x01, 0x02, 0x03, 0x00, // E088 tiles
+};
+
+static void test_four_screen(ppu_backend_t backend) {
+  static const uint8_t colors[4]={0x16, 0x2A, 0x12, 0x0F};
+  const char *name=ppu_backend_name(backend);
+  test_rom_t rom;
+  console_t *console;
+  int table, line, x, wrong;
+
+  test_rom_init(&rom, 0, TEST_ROM_FOUR_SCREEN, 2, 1);
+  test_rom_code(&rom, 0xE000, four_screen_code, sizeof(four_screen_code));
+  test_rom_vectors(&rom, 0xE06B, 0xE000, 0xE06B);
+  for (table=1; table<4; table++) {
+    test_rom_solid_tile(&rom, table*16, table);
+  }
+
+  console=test_console_create(&rom, backend);
+  TEST_CHECK(console!=NULL, "[%s] four screen: unable to create the console", name);
+  if (console==NULL) {
+    return;
+  }
+
+  for (int frame=0; frame<5; frame++) {
+    nes_iterate_frame(&console->tNES);
+  }
+  for (table=0; table<4; table++) {
+    TEST_CHECK(console->tNES.ram_data[0x20+table]==((table+1)&3), "[%s] four screen: name table %d reads tile %d",
+      name, table, console->tNES.ram_data[0x20+table]);
+  }
+
+  // the nmi selects the table of the next frame
+  for (table=0; table<4; table++) {
+    console->tNES.ram_data[0x30]=table;
+    nes_iterate_frame(&console->tNES);
+    nes_iterate_frame(&console->tNES);
+
+    wrong=0;
+    for (line=0; line<240; line++) {
+      for (x=0; x<256; x++) {
+        wrong+=(console->chFrame[line*256+x]!=(line<8?colors[table]:0x0F));
+      }
+    }
+    TEST_CHECK(wrong==0, "[%s] four screen: %d wrong pixels showing name table %d", name, wrong, table);
+  }
+  free(console);
+}
+
+// NES 2.0 headers describing less than the mappers can switch (8KByte PRG-ROM, 1KByte CHR) are rejected
+static void test_nes20_header(const char *description, uint8_t prg_low, uint8_t chr_low, uint8_t rom_size_high,
+                              uint8_t chr_ram_shift, cartridge_err_t expected) {
+  test_rom_t rom;
+  cartridge_info_t info;
+  cartridge_err_t result;
+
+  test_rom_init(&rom, 0, 0, 2, 1);
+  rom.header[4]=prg_low;
+  rom.header[5]=chr_low;
+  rom.header[7]|=0x08;
+  rom.header[9]=rom_size_high;
+  rom.header[11]=chr_ram_shift;
+
+  result=cartridge_parse(rom.data, rom.size, &info);
+  TEST_CHECK(result==expected, "nes 2.0 %s: cartridge_parse() returns %d instead of %d", description, result, expected);
+  if (expected!=ok) {
+    TEST_CHECK(console_size(rom.data, rom.size)==0, "nes 2.0 %s: console_size() accepts the image", description);
+  }
+}
+
+static void test_nes20_headers(void) {
+  test_nes20_header("32KByte PRG-ROM, 8KByte CHR-ROM", 2, 1, 0x00, 0, ok);
+  test_nes20_header("8KByte CHR-RAM", 2, 0, 0x00, 7, ok);
+  test_nes20_header("24KByte PRG-ROM (exponent)", (13<<2)|1, 1, 0x0F, 0, ok);
+  test_nes20_header("no CHR-ROM and no CHR-RAM", 2, 0, 0x00, 0, err_invalid_rom);
+  test_nes20_header("4KByte PRG-ROM (exponent)", 12<<2, 1, 0x0F, 0, err_invalid_rom);
+  test_nes20_header("512Byte CHR-ROM (exponent)", 2, 9<<2, 0xF0, 0, err_invalid_rom);
+}
+
+// change 4 bytes at offset of PRG-ROM so the crc32 of PRG-ROM and CHR-ROM becomes crc (crc32 is linear in the data bits)
+static void test_rom_force_crc32(test_rom_t *rom, uint32_t offset, uint32_t crc) {
+  uint8_t *patch=rom->prg+offset;
+  uint32_t size=rom->size-16, base, target, bits=0, basis[32]={0}, combination[32];
+
+  memset(patch, 0, 4);
+  base=hash_crc32(HASH_CRC32_INIT, rom->prg, size);
+  // gaussian elimination over GF(2): basis[b] has its highest bit at b and is the crc change of the patch bits in combination[b]
+  for (int n=0; n<32; n++) {
+    uint32_t change, bit=1u<<n;
+
+    patch[n>>3]=1<<(n&7);
+    change=hash_crc32(HASH_CRC32_INIT, rom->prg, size)^base;
+    patch[n>>3]=0;
+    for (int b=31; b>=0 && change; b--) {
+      if (change>>b&1) {
+        if (basis[b]==0) {
+          basis[b]=change;
+          combination[b]=bit;
+          break;
+        }
+        change^=basis[b];
+        bit^=combination[b];
+      }
+    }
+  }
+  target=crc^base;
+  for (int b=31; b>=0; b--) {
+    if (target>>b&1) {
+      target^=basis[b];
+      bits^=combination[b];
+    }
+  }
+  for (int n=0; n<4; n++) {
+    patch[n]=bits>>(n*8);
+  }
+}
+
+// an iNES header of a known ROM is corrected by the ROM database, a NES 2.0 header is trusted
+static void test_rom_database(void) {
+  test_rom_t rom;
+  cartridge_info_t info;
+
+  // the image of a CNROM game (Pipe Dream) with mapper 0, horizontal mirroring and 32KByte PRG-RAM in the header
+  test_rom_init(&rom, 0, 0, 2, 1);
+  rom.header[8]=4;
+  test_rom_force_crc32(&rom, 0, 0xBC065FC3);
+  TEST_CHECK(hash_crc32(HASH_CRC32_INIT, rom.prg, rom.size-16)==0xBC065FC3, "database: the crc32 of the image is not forced");
+  TEST_CHECK(cartridge_parse(rom.data, rom.size, &info)==ok, "database: cartridge_parse() fails");
+  TEST_CHECK(info.hwMapper==3 && info.chMirror==CARTRIDGE_MIRROR_VERTICAL && info.wPRGRAMSize==0,
+             "database: mapper %u, mirroring %u, %u bytes PRG-RAM instead of 3, %u, 0", (unsigned)info.hwMapper,
+             (unsigned)info.chMirror, (unsigned)info.wPRGRAMSize, CARTRIDGE_MIRROR_VERTICAL);
+  TEST_CHECK(cartridge_ram_size(rom.data, rom.size)==0x800, "database: %u bytes cartridge RAM instead of the name tables only",
+             (unsigned)cartridge_ram_size(rom.data, rom.size));
+
+  rom.header[7]|=0x08;
+  rom.header[8]=0;
+  rom.header[10]=7;
+  TEST_CHECK(cartridge_parse(rom.data, rom.size, &info)==ok && info.hwMapper==0 && info.wPRGRAMSize==0x2000,
+             "database: a NES 2.0 header is corrected");
+
+  // text of a dumper in bytes 7-15 of an unknown ROM, the upper mapper bits and the RAM size are garbage
+  test_rom_init(&rom, 0, 0, 2, 1);
+  memcpy(rom.header+7, "DiskDude!", 9);
+  TEST_CHECK(cartridge_parse(rom.data, rom.size, &info)==ok && info.hwMapper==0 && info.wPRGRAMSize==0x2000,
+             "database: \"DiskDude!\" is taken as mapper %u", (unsigned)info.hwMapper);
+  memcpy(rom.header+7, "\x40\x20\0\0\0Ripp", 9);
+  TEST_CHECK(cartridge_parse(rom.data, rom.size, &info)==ok && info.hwMapper==0 && info.wPRGRAMSize==0x2000,
+             "database: text in bytes 12-15 is taken as mapper %u", (unsigned)info.hwMapper);
+}
+
+int main(void) {
+  test_nes20_headers();
+  test_rom_database();
+  for (ppu_backend_t backend=0; backend<PPU_BACKEND_COUNT; backend++) {
+    test_mmc3_irq(backend);
+    test_four_screen(backend);
+  }
+
+  if (test_failed) {
+    printf("cartridge: %d checks failed\n", test_failed);
+    return 1;
+  }
+  printf("cartridge: all checks passed\n");
+  return 0;
+}
@@ -0,0 +1,406 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test_rom.h"
+#include "env.h"
+#include "export.h"
+
+// console_clone(), the env wrapper and the export, checked with a game whose picture and battery RAM follow the input
+
+static const uint8_t game_code[]={
+  0x78,                   // E000 SEI
+  0xD8,                   // E001 CLD
+  0xA2, 0xFF,             // E002 LDX #$FF
+  0x9A,                   // E004 TXS
+  0x2C, 0x02, 0x20,       // E005 BIT $2002     wait for two vblanks
+  0x10, 0xFB,             // E008 BPL $E005
+  0x2C, 0x02, 0x20,       // E00A BIT $2002
+  0x10, 0xFB,             // E00D BPL $E00A
+  0xA9, 0x20,             // E00F LDA #$20      name and attribute table 0: 0, 1, 2, ...
+  0x8D, 0x06, 0x20,       // E011 STA $2006
+  0xA9, 0x00,             // E014 LDA #$00
+  0x8D, 0x06, 0x20,       // E016 STA $2006
+  0xA0, 0x04,             // E019 LDY #$04
+  0xA2, 0x00,             // E01B LDX #$00
+  0x8E, 0x07, 0x20,       // E01D STX $2007
+  0xE8,                   // E020 INX
+  0xD0, 0xFA,             // E021 BNE $E01D
+  0x88,                   // E023 DEY
+  0xD0, 0xF7,             // E024 BNE $E01D
+  0xA9, 0x80,             // E026 LDA #$80      nmi
+  0x8D, 0x00, 0x20,       // E028 STA $2000
+  0xA9, 0x0A,             // E02B LDA #$0A      background
+  0x8D, 0x01, 0x20,       // E02D STA $2001
+  0x4C, 0x30, 0xE0,       // E030 JMP $E030
+  // nmi: controller 1 to $00
+  0x48,                   // E033 PHA
+  0xA9, 0x01,             // E034 LDA #$01
+  0x8D, 0x16, 0x40,       // E036 STA $4016
+  0xA9, 0x00,             // E039 LDA #$00
+  0x8D, 0x16, 0x40,       // E03B STA $4016
+  0xA2, 0x08,             // E03E LDX #$08
+  0xAD, 0x16, 0x40,       // E040 LDA $4016
+  0x4A,                   // E043 LSR A
+  0x26, 0x00,             // E044 ROL $00
+  0xCA,                   // E046 DEX
+  0xD0, 0xF7,             // E047 BNE $E040
+  0xAD, 0x00, 0x60,       // E049 LDA $6000     battery RAM: $6000 += buttons, $6001 counts the frames
+  0x18,                   // E04C CLC
+  0x65, 0x00,             // E04D ADC $00
+  0x8D, 0x00, 0x60,       // E04F STA $6000
+  0xEE, 0x01, 0x60,       // E052 INC $6001
+  0xA9, 0x3F,             // E055 LDA #$3F      background palette from $6000
+  0x8D, 0x06, 0x20,       // E057 STA $2006
+  0xA9, 0x00,             // E05A LDA #$00
+  0x8D, 0x06, 0x20,       // E05C STA $2006
+  0xAD, 0x00, 0x60,       // E05F LDA $6000
+  0xA2, 0x04,             // E062 LDX #$04
+  0x29, 0x3F,             // E064 AND #$3F
+  0x8D, 0x07, 0x20,       // E066 STA $2007
+  0x18,                   // E069 CLC
+  0x69, 0x11,             // E06A ADC #$11
+  0xCA,                   // E06C DEX
+  0xD0, 0xF5,             // E06D BNE $E064
+  0x2C, 0x02, 0x20,       // E06F BIT $2002     scroll x by the frame counter
+  0xAD, 0x01, 0x60,       // E072 LDA $6001
+  0x8D, 0x05, 0x20,       // E075 STA $2005
+  0xA9, 0x00,             // E078 LDA #$00
+  0x8D, 0x05, 0x20,       // E07A STA $2005
+  0xA9, 0x80,             // E07D LDA #$80
+  0x8D, 0x00, 0x20,       // E07F STA $2000
+  0x68,                   // E082 PLA
+  0x40,                   // E083 RTI
+};
+
+#define BATTERY_SIZE  0x2000
+#define CLONE_FRAME   20
+#define LAST_FRAME    50
+
+// NROM with battery backed PRG-RAM, the CHR-ROM is noise so every tile looks different
+static void game_rom(test_rom_t *rom) {
+  uint32_t seed=1;
+
+  test_rom_init(rom, 0, TEST_ROM_BATTERY, 2, 1);
+  test_rom_code(rom, 0xE000, game_code, sizeof(game_code));
+  test_rom_vectors(rom, 0xE033, 0xE000, 0xE033);
+  for (uint32_t n=0; n<0x2000; n++) {
+    seed=seed*1103515245+12345;
+    rom->chr[n]=seed>>16;
+  }
+}
+
+static uint8_t game_input(int frame) {
+  return (frame*37+(frame>>3))&0xFF;
+}
+
+// a clone continues exactly like a console which ran all frames itself, without touching the save of the original
+static void test_clone(ppu_backend_t backend) {
+  const char *name=ppu_backend_name(backend);
+  static uint8_t battery[BATTERY_SIZE], battery_replay[BATTERY_SIZE], battery_copy[BATTERY_SIZE];
+  console_t *console, *replay, *clone=NULL;
+  test_rom_t rom;
+  int frame;
+
+  game_rom(&rom);
+  for (uint32_t n=0; n<BATTERY_SIZE; n++) {
+    battery[n]=battery_replay[n]=n*7;
+  }
+
+  console=test_console_create(&rom, backend);
+  replay=test_console_create(&rom, backend);
+  TEST_CHECK(console!=NULL && replay!=NULL, "[%s] clone: unable to create the consoles", name);
+  if (console==NULL || replay==NULL) {
+    free(console);
+    free(replay);
+    return;
+  }
+  TEST_CHECK(cartridge_battery_ram_size(&console->tCartridge)==BATTERY_SIZE, "[%s] clone: %u bytes of battery RAM", name,
+    (unsigned int)cartridge_battery_ram_size(&console->tCartridge));
+  TEST_CHECK(cartridge_attach_battery_ram(&console->tCartridge, battery, BATTERY_SIZE)==ok,
+    "[%s] clone: unable to attach the battery RAM", name);
+  TEST_CHECK(cartridge_attach_battery_ram(&replay->tCartridge, battery_replay, BATTERY_SIZE)==ok,
+    "[%s] clone: unable to attach the battery RAM of the replay", name);
+
+  for (frame=0; frame<LAST_FRAME; frame++) {
+    uint8_t input[2]={game_input(frame), 0};
+
+    if (frame==CLONE_FRAME) {
+      if (posix_memalign((void **)&clone, JEG_CACHE_LINE_SIZE, console->wBlockSize)) {
+        clone=NULL;
+        break;
+      }
+      TEST_CHECK(console_clone(clone, console->wBlockSize, console)==ok, "[%s] clone: console_clone() failed", name);
+      TEST_CHECK(clone->tCartridge.pchPRGRAM==clone->chRAM, "[%s] clone: the battery RAM is not copied into the clone",
+        name);
+      memcpy(battery_copy, battery, BATTERY_SIZE);
+    }
+
+    if (clone==NULL) {
+      console_iterate_frames(&console, input, 1, 1);
+    } else {
+      console_iterate_frames(&clone, input, 1, 1);
+    }
+    console_iterate_frames(&replay, input, 1, 1);
+    if (clone==NULL) {
+      continue;
+    }
+
+    TEST_CHECK(memcmp(clone->chFrame, replay->chFrame, sizeof(clone->chFrame))==0,
+      "[%s] clone: the picture of frame %d differs", name, frame);
+    TEST_CHECK(memcmp(clone->tNES.ram_data, replay->tNES.ram_data, sizeof(clone->tNES.ram_data))==0,
+      "[%s] clone: the cpu RAM of frame %d differs", name, frame);
+    TEST_CHECK(memcmp(clone->tCartridge.pchPRGRAM, battery_replay, BATTERY_SIZE)==0,
+      "[%s] clone: the battery RAM of frame %d differs", name, frame);
+  }
+  TEST_CHECK(clone!=NULL, "[%s] clone: no clone made", name);
+  TEST_CHECK(battery_replay[1]-7>=LAST_FRAME-CLONE_FRAME, "[%s] clone: the game counted only %d frames", name,
+    battery_replay[1]-7);
+  TEST_CHECK(memcmp(battery, battery_copy, BATTERY_SIZE)==0, "[%s] clone: the clone wrote the battery RAM of the original",
+    name);
+
+  free(clone);
+  free(replay);
+  free(console);
+}
+
+// the picture buffer of the host stays with the original, a clone draws palette values into its own chFrame
+static void test_clone_picture(ppu_backend_t backend) {
+  const char *name=ppu_backend_name(backend);
+  static uint32_t picture[256*240], picture_copy[256*240];
+  console_t *console, *replay, *clone;
+  uint8_t input[2]={0, 0};
+  test_rom_t rom;
+
+  game_rom(&rom);
+  console=test_console_create(&rom, backend);
+  replay=test_console_create(&rom, backend);
+  TEST_CHECK(console!=NULL && replay!=NULL, "[%s] clone picture: unable to create the consoles", name);
+  if (console==NULL || replay==NULL || posix_memalign((void **)&clone, JEG_CACHE_LINE_SIZE, console->wBlockSize)) {
+    free(console);
+    free(replay);
+    return;
+  }
+  TEST_CHECK(ppu_set_pixel_format(&console->tPPU, PPU_PIXEL_ARGB8888, picture),
+    "[%s] clone picture: ppu_set_pixel_format() failed", name);
+
+  for (int frame=0; frame<CLONE_FRAME; frame++) {
+    console_iterate_frames(&console, input, 1, 1);
+    console_iterate_frames(&replay, input, 1, 1);
+  }
+  TEST_CHECK(console_clone(clone, console->wBlockSize, console)==ok, "[%s] clone picture: console_clone() failed", name);
+  memcpy(picture_copy, picture, sizeof(picture));
+  for (int frame=0; frame<2; frame++) {
+    console_iterate_frames(&clone, input, 1, 1);
+    console_iterate_frames(&replay, input, 1, 1);
+  }
+
+  TEST_CHECK(memcmp(picture, picture_copy, sizeof(picture))==0, "[%s] clone picture: the clone drew into the host buffer",
+    name);
+  TEST_CHECK(memcmp(clone->chFrame, replay->chFrame, sizeof(clone->chFrame))==0,
+    "[%s] clone picture: the clone does not draw palette values into its chFrame", name);
+
+  free(clone);
+  free(replay);
+  free(console);
+}
+
+// a batch of clones on several threads against the same clones run one by one, each with its own input
+#define BATCH_SIZE 7
+#define BATCH_THREADS 3
+
+static void test_iterate_frames(ppu_backend_t backend) {
+  const char *name=ppu_backend_name(backend);
+  console_t *console[2*BATCH_SIZE]={NULL}, *source;
+  uint8_t input[2*BATCH_SIZE];
+  test_rom_t rom;
+  int n, frame;
+
+  game_rom(&rom);
+  source=test_console_create(&rom, backend);
+  TEST_CHECK(source!=NULL, "[%s] iterate frames: unable to create the console", name);
+  if (source==NULL) {
+    return;
+  }
+  for (frame=0; frame<CLONE_FRAME; frame++) {
+    uint8_t start[2]={game_input(frame), 0};
+
+    console_iterate_frames(&source, start, 1, 1);
+  }
+  for (n=0; n<2*BATCH_SIZE; n++) {
+    if (posix_memalign((void **)&console[n], JEG_CACHE_LINE_SIZE, source->wBlockSize)
+        || console_clone(console[n], source->wBlockSize, source)!=ok) {
+      TEST_CHECK(0, "[%s] iterate frames: unable to clone the console", name);
+      break;
+    }
+  }
+
+  // console[0..BATCH_SIZE-1] on threads, console[BATCH_SIZE..] one by one
+  for (frame=0; n==2*BATCH_SIZE && frame<LAST_FRAME-CLONE_FRAME; frame++) {
+    for (int k=0; k<BATCH_SIZE; k++) {
+      input[k*2]=game_input(frame*BATCH_SIZE+k);
+      input[k*2+1]=0;
+    }
+    console_iterate_frames(console, input, BATCH_SIZE, BATCH_THREADS);
+    for (int k=0; k<BATCH_SIZE; k++) {
+      console_iterate_frames(&console[BATCH_SIZE+k], &input[k*2], 1, 1);
+    }
+  }
+  for (int k=0; n==2*BATCH_SIZE && k<BATCH_SIZE; k++) {
+    TEST_CHECK(memcmp(console[k]->chFrame, console[BATCH_SIZE+k]->chFrame, sizeof(console[k]->chFrame))==0,
+      "[%s] iterate frames: the picture of console %d differs", name, k);
+    TEST_CHECK(memcmp(console[k]->tNES.ram_data, console[BATCH_SIZE+k]->tNES.ram_data, sizeof(console[k]->tNES.ram_data))==0,
+      "[%s] iterate frames: the cpu RAM of console %d differs", name, k);
+    TEST_CHECK(memcmp(console[k]->tCartridge.pchPRGRAM, console[BATCH_SIZE+k]->tCartridge.pchPRGRAM, BATTERY_SIZE)==0,
+      "[%s] iterate frames: the PRG-RAM of console %d differs", name, k);
+  }
+  // the game sums up the buttons in $6000
+  TEST_CHECK(n<2*BATCH_SIZE || console[0]->tCartridge.pchPRGRAM[0]!=console[1]->tCartridge.pchPRGRAM[0],
+    "[%s] iterate frames: the inputs did not reach the consoles", name);
+
+  for (n=0; n<2*BATCH_SIZE; n++) {
+    free(console[n]);
+  }
+  free(source);
+}
+
+// area resampling 256x240 -> 84x84 as the plain mean over the covered area (in 1/84 pixels)
+static void resize_reference(const uint8_t *gray, uint8_t *out) {
+  for (int out_y=0; out_y<ENV_RESIZED_SIZE; out_y++) {
+    for (int out_x=0; out_x<ENV_RESIZED_SIZE; out_x++) {
+      uint32_t sum=0;
+
+      for (int y=out_y*ENV_FRAME_HEIGHT/ENV_RESIZED_SIZE; y<ENV_FRAME_HEIGHT && y*ENV_RESIZED_SIZE<(out_y+1)*ENV_FRAME_HEIGHT; y++) {
+        int top=y*ENV_RESIZED_SIZE>out_y*ENV_FRAME_HEIGHT?y*ENV_RESIZED_SIZE:out_y*ENV_FRAME_HEIGHT;
+        int bottom=(y+1)*ENV_RESIZED_SIZE<(out_y+1)*ENV_FRAME_HEIGHT?(y+1)*ENV_RESIZED_SIZE:(out_y+1)*ENV_FRAME_HEIGHT;
+
+        for (int x=0; x<ENV_FRAME_WIDTH; x++) {
+          int left=x*ENV_RESIZED_SIZE>out_x*ENV_FRAME_WIDTH?x*ENV_RESIZED_SIZE:out_x*ENV_FRAME_WIDTH;
+          int right=(x+1)*ENV_RESIZED_SIZE<(out_x+1)*ENV_FRAME_WIDTH?(x+1)*ENV_RESIZED_SIZE:(out_x+1)*ENV_FRAME_WIDTH;
+
+          if (right>left) {
+            sum+=(right-left)*(bottom-top)*gray[y*ENV_FRAME_WIDTH+x];
+          }
+        }
+      }
+      out[out_y*ENV_RESIZED_SIZE+out_x]=(sum+ENV_FRAME_WIDTH*ENV_FRAME_HEIGHT/2)/(ENV_FRAME_WIDTH*ENV_FRAME_HEIGHT);
+    }
+  }
+}
+
+// the observations of env_step() against a clone stepped frame by frame and a scalar reference
+static void test_env(ppu_backend_t backend) {
+  const char *name=ppu_backend_name(backend);
+  static uint8_t gray[ENV_FRAME_HEIGHT*ENV_FRAME_WIDTH], previous[ENV_FRAME_HEIGHT*ENV_FRAME_WIDTH];
+  static uint8_t pooled[ENV_FRAME_HEIGHT*ENV_FRAME_WIDTH];
+  uint8_t resized[ENV_RESIZED_SIZE*ENV_RESIZED_SIZE], expected[ENV_RESIZED_SIZE*ENV_RESIZED_SIZE];
+  console_t *console[3]={NULL, NULL, NULL};
+  env_t env_gray, env_resized, env_pooled;
+  test_rom_t rom;
+  int n, step, wrong;
+
+  game_rom(&rom);
+  console[0]=test_console_create(&rom, backend);
+  TEST_CHECK(console[0]!=NULL, "[%s] env: unable to create the console", name);
+  if (console[0]==NULL) {
+    return;
+  }
+  for (n=1; n<3; n++) {
+    if (posix_memalign((void **)&console[n], JEG_CACHE_LINE_SIZE, console[0]->wBlockSize)
+        || console_clone(console[n], console[0]->wBlockSize, console[0])!=ok) {
+      TEST_CHECK(0, "[%s] env: unable to clone the console", name);
+      return;
+    }
+  }
+
+  TEST_CHECK(env_observation_size(ENV_OBSERVATION_GRAYSCALE_84)==sizeof(resized), "[%s] env: wrong observation size", name);
+  env_init(&env_gray, console[0], ENV_OBSERVATION_GRAYSCALE, false);
+  env_init(&env_resized, console[1], ENV_OBSERVATION_GRAYSCALE_84, false);
+  env_init(&env_pooled, console[2], ENV_OBSERVATION_GRAYSCALE, true);
+
+  for (step=0; step<10; step++) {
+    uint8_t action=game_input(step);
+
+    // two frames per step: the pooled env takes the maximum of both
+    env_step(&env_gray, action, 1, previous);
+    env_step(&env_gray, action, 1, gray);
+    env_step(&env_resized, action, 2, resized);
+    env_step(&env_pooled, action, 2, pooled);
+
+    resize_reference(gray, expected);
+    wrong=0;
+    for (n=0; n<ENV_RESIZED_SIZE*ENV_RESIZED_SIZE; n++) {
+      wrong+=(resized[n]!=expected[n]);
+    }
+    TEST_CHECK(wrong==0, "[%s] env: %d resized pixels differ in step %d", name, wrong, step);
+
+    wrong=0;
+    for (n=0; n<ENV_FRAME_HEIGHT*ENV_FRAME_WIDTH; n++) {
+      wrong+=(pooled[n]!=(gray[n]>previous[n]?gray[n]:previous[n]));
+    }
+    TEST_CHECK(wrong==0, "[%s] env: %d max-pooled pixels differ in step %d", name, wrong, step);
+  }
+  TEST_CHECK(memcmp(gray, previous, sizeof(gray))!=0, "[%s] env: the frames of a step are equal, nothing to pool", name);
+
+  for (n=0; n<3; n++) {
+    free(console[n]);
+  }
+}
+
+// a frame published to an anonymous segment reads back from a second mapping
+static void test_export(void) {
+  static uint8_t frame[EXPORT_FRAME_SIZE], read_frame[EXPORT_FRAME_SIZE];
+  uint8_t ram[EXPORT_RAM_SIZE], read_ram[EXPORT_RAM_SIZE];
+  export_t writer, reader;
+  uint64_t count=0;
+  export_err_t result;
+
+  result=export_create(&writer, NULL, 2);
+  TEST_CHECK(result==export_ok, "export: export_create() returns %d", result);
+  if (result!=export_ok) {
+    return;
+  }
+  result=export_open_fd(&reader, export_fd(&writer));
+  TEST_CHECK(result==export_ok, "export: export_open_fd() returns %d", result);
+  if (result!=export_ok) {
+    export_close(&writer);
+    return;
+  }
+  TEST_CHECK(export_slots(&reader)==2, "export: %u slots", (unsigned int)export_slots(&reader));
+  TEST_CHECK(!export_read(&reader, 1, read_frame, read_ram, &count), "export: an empty slot reads a frame");
+
+  for (int published=1; published<=2; published++) {
+    for (uint32_t n=0; n<EXPORT_FRAME_SIZE; n++) {
+      frame[n]=(n*published)&0x3F;
+    }
+    for (uint32_t n=0; n<EXPORT_RAM_SIZE; n++) {
+      ram[n]=n+published;
+    }
+    export_publish(&writer, 1, frame, ram);
+
+    TEST_CHECK(export_read(&reader, 1, read_frame, read_ram, &count), "export: the published slot reads nothing");
+    TEST_CHECK(count==(uint64_t)published, "export: frame count %u instead of %d", (unsigned int)count, published);
+    TEST_CHECK(memcmp(frame, read_frame, sizeof(frame))==0, "export: the picture of frame %d differs", published);
+    TEST_CHECK(memcmp(ram, read_ram, sizeof(ram))==0, "export: the cpu RAM of frame %d differs", published);
+  }
+  TEST_CHECK(!export_read(&reader, 0, NULL, NULL, &count), "export: slot 0 reads the frames of slot 1");
+
+  export_close(&reader);
+  export_close(&writer);
+}
+
+int main(void) {
+  for (ppu_backend_t backend=0; backend<PPU_BACKEND_COUNT; backend++) {
+    test_clone(backend);
+    test_clone_picture(backend);
+    test_iterate_frames(backend);
+    test_env(backend);
+  }
+  test_export();
+
+  if (test_failed) {
+    printf("console: %d checks failed\n", test_failed);
+    return 1;
+  }
+  printf("console: all checks passed\n");
+  return 0;
+}
@@ -0,0 +1,84 @@
+#ifndef TEST_ROM_H
+#define TEST_ROM_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "console.h"
+
+// iNES images built in memory: the code and the vectors are placed in the last 8KByte of PRG-ROM (0xE000-0xFFFF)
+
+typedef struct {
+  uint8_t data[16+0x8000+0x2000];
+  uint32_t size;
+  uint8_t *header;
+  uint8_t *prg;
+  uint32_t prg_size;
+  uint8_t *chr;
+} test_rom_t;
+
+// header flags of byte 6
+#define TEST_ROM_VERTICAL     0x01
+#define TEST_ROM_BATTERY      0x02
+#define TEST_ROM_FOUR_SCREEN  0x08
+
+// prg_banks in 16KByte (at most 2), chr_banks in 8KByte (at most 1)
+static inline void test_rom_init(test_rom_t *rom, uint8_t mapper, uint8_t flags, uint8_t prg_banks, uint8_t chr_banks) {
+  memset(rom, 0, sizeof(*rom));
+  rom->header=rom->data;
+  memcpy(rom->header, "NES\x1A", 4);
+  rom->header[4]=prg_banks;
+  rom->header[5]=chr_banks;
+  rom->header[6]=(mapper<<4)|flags;
+  rom->header[7]=mapper&0xF0;
+  rom->prg=rom->data+16;
+  rom->prg_size=prg_banks*0x4000;
+  rom->chr=rom->prg+rom->prg_size;
+  rom->size=16+rom->prg_size+chr_banks*0x2000;
+}
+
+// copy code to a cpu address of the last 8KByte
+static inline void test_rom_code(test_rom_t *rom, uint16_t address, const uint8_t *code, uint32_t size) {
+  memcpy(rom->prg+rom->prg_size-0x2000+(address-0xE000), code, size);
+}
+
+static inline void test_rom_vectors(test_rom_t *rom, uint16_t nmi, uint16_t reset, uint16_t irq) {
+  uint8_t vectors[6]={nmi&0xFF, nmi>>8, reset&0xFF, reset>>8, irq&0xFF, irq>>8};
+
+  test_rom_code(rom, 0xFFFA, vectors, sizeof(vectors));
+}
+
+// fill the 16 byte pattern of a tile in CHR with a solid color (1-3)
+static inline void test_rom_solid_tile(test_rom_t *rom, uint32_t address, uint8_t color) {
+  memset(rom->chr+address, (color&1)?0xFF:0x00, 8);
+  memset(rom->chr+address+8, (color&2)?0xFF:0x00, 8);
+}
+
+// a console in a cache line aligned block, NULL if the image is refused
+static inline console_t *test_console_create(const test_rom_t *rom, ppu_backend_t backend) {
+  uint32_t bytes=console_size(rom->data, rom->size);
+  console_t *console;
+
+  if (bytes==0 || posix_memalign((void **)&console, JEG_CACHE_LINE_SIZE, bytes)) {
+    return NULL;
+  }
+  if (console_init(console, bytes, backend, rom->data, rom->size)) {
+    free(console);
+    return NULL;
+  }
+  return console;
+}
+
+static int test_failed=0;
+
+#define TEST_CHECK(condition, ...) do {                                     \
+    if (!(condition)) {                                                     \
+      printf("%s:%d: ", __FILE__, __LINE__);                                \
+      printf(__VA_ARGS__);                                                  \
+      printf("\n");                                                         \
+      test_failed++;                                                        \
+    }                                                                       \
+  } while (0)
+
+#endif
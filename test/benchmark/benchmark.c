@@ -1,18 +1,27 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include "ppu_framebuffer.h"
-#include "cartridge.h"
+#include <stddef.h>
+#include <time.h>
+#include "console.h"
+#include "rom.h"
 #include "nes.h"
 
+#define FRAMES 1000
+#define CLONES 10000
+
+// sums up the area a display driver would have to update
+static void count_rect(void *tag, uint_fast16_t x, uint_fast16_t y, uint_fast16_t width, uint_fast16_t height) {
+  *(uint64_t *)tag+=width*height;
+}
+
 int main(int argc, char* argv[]) {
-  int i, result;
-  ppu_t ppu;
-  cartridge_t cartridge;
-  nes_t nes_console;
-  FILE *rom_file;
-  uint8_t *rom_data;
-  uint32_t rom_size;
-  uint8_t video_frame_data[256*240];
+  int i, result, duplicates;
+  uint64_t dirty_pixels;
+  console_t *console, *clone;
+  uint32_t console_bytes;
+  const rom_t *rom;
+  clock_t start;
+  double seconds;
 
   // load rom file
   if (argc<2) {
@@ -20,38 +29,70 @@ int main(int argc, char* argv[]) {
     return 1;
   }
 
-  rom_file=fopen(argv[1], "rb");
-
-  if (rom_file==NULL) {
+  if (rom_open(&rom, argv[1])!=rom_ok) {
     printf("not able to open rom file %s\n", argv[1]);
     return 2;
   }
 
-  fseek(rom_file, 0, SEEK_END);
-  rom_size=ftell(rom_file);
-  fseek(rom_file, 0, SEEK_SET);
-  rom_data=malloc(rom_size);
-  if (fread(rom_data, 1, rom_size, rom_file)!=rom_size) {
-    printf("unable to read data from rom file %s\n", argv[1]);
-    return 3;
-  }
-  fclose(rom_file);
-
-  // init nes
-  ppu_init(&nes_console, &ppu, video_frame_data);
-  result = cartridge_init(&nes_console, &cartridge, rom_data, rom_size);  
-  nes_init(&nes_console);
-  if (result) {
-    printf("unable to parse rom file (result:%d)\n", result);
+  console_bytes=console_size(rom->pchData, rom->wSize);
+  if (console_bytes==0 || posix_memalign((void **)&console, JEG_CACHE_LINE_SIZE, console_bytes)) {
+    printf("unable to parse rom file\n");
     return 6;
   }
 
-  for (i=0; i<1000; i++) {
-    nes_iterate_frame(&nes_console);    
+  // memory layout of one console instance
+  for (i=0; i<console_layout_size; i++) {
+    printf("%-16s offset %6u size %6u\n", console_layout[i].pchName,
+      (unsigned int)console_layout[i].wOffset, (unsigned int)console_layout[i].wSize);
+  }
+  printf("%-16s offset %6u size %6u\n", "cartridge ram", (unsigned int)offsetof(console_t, chRAM),
+    (unsigned int)(console_bytes-offsetof(console_t, chRAM)));
+  printf("%-16s %u bytes per instance\n", "total", (unsigned int)console_bytes);
+
+  // run the same rom on every ppu backend
+  for (ppu_backend_t backend=0; backend<PPU_BACKEND_COUNT; backend++) {
+    // init nes
+    result = console_init(console, console_bytes, backend, rom->pchData, rom->wSize);
+    if (result) {
+      printf("unable to parse rom file (result:%d)\n", result);
+      return 6;
+    }
+
+    // frames without any changed pixel could be skipped by a host, others updated in parts
+    duplicates=0;
+    dirty_pixels=0;
+    start=clock();
+    for (i=0; i<FRAMES; i++) {
+      nes_iterate_frame(&console->tNES);
+      if (!ppu_frame_changed(&console->tPPU)) {
+        duplicates++;
+      }
+      ppu_push_dirty_rects(&console->tPPU, count_rect, &dirty_pixels);
+    }
+    seconds=(double)(clock()-start)/CLOCKS_PER_SEC;
+
+    printf("%-12s %d frames in %.3f s (%.1f fps), %.1f%% duplicate frames, %.1f%% of the pixels updated\n",
+      ppu_backend_name(backend), FRAMES, seconds, seconds>0?FRAMES/seconds:0.0, 100.0*duplicates/FRAMES,
+      100.0*dirty_pixels/((double)FRAMES*256*240));
+
+    // branching a running console
+    if (posix_memalign((void **)&clone, JEG_CACHE_LINE_SIZE, console_bytes)) {
+      printf("out of memory\n");
+      return 7;
+    }
+    start=clock();
+    for (i=0; i<CLONES; i++) {
+      console_clone(clone, console_bytes, console);
+    }
+    seconds=(double)(clock()-start)/CLOCKS_PER_SEC;
+    printf("%-12s %d clones in %.3f s (%.2f us per clone)\n", ppu_backend_name(backend), CLONES, seconds,
+      seconds*1e6/CLONES);
+    free(clone);
   }
 
-  free(rom_data);
-  
+  free(console);
+  rom_close(rom);
+  rom_cache_clear();
+
   return 0;
 }
-
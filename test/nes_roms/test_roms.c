@@ -1,8 +1,9 @@
 #include <stdio.h>
 #include <SDL.h>
-#include "ppu_framebuffer.h"
+#include "ppu.h"
 #include "controller_direct.h"
 #include "cartridge.h"
+#include "rom.h"
 #include "nes.h"
 
 // global variables
@@ -57,37 +58,27 @@ void update_frame(uint8_t* frame_data, int width, int height) {
 
 typedef enum test_mode_t {RECORD, PLAY, ACCEPT} test_mode_t;
 
-uint8_t *rom_data=0;
+const rom_t *rom=NULL;
+uint8_t *cartridge_ram=NULL;
 cartridge_t cartridge; 
 
 int load_rom(nes_t *nes, char *filename) {
-  FILE *rom_file;
-  uint32_t rom_size=0;
+  uint32_t ram_size;
   int result;
  
   uint8_t key_value;
 
-  rom_file=fopen(filename, "rb");
-
-  if (rom_file==NULL) {
+  rom_close(rom); // stays cached, e.g. for the next test of the same rom
+  rom=NULL;
+  if (rom_open(&rom, filename)!=rom_ok) {
     printf("not able to open rom file %s\n", filename);
     return 1;
   }
 
-  fseek(rom_file, 0, SEEK_END);
-  rom_size=ftell(rom_file);
-  fseek(rom_file, 0, SEEK_SET);
-  if (rom_data) { 
-    free(rom_data);
-  }
-  rom_data=malloc(rom_size);
-  if (fread(rom_data, 1, rom_size, rom_file)!=rom_size) {
-    printf("unable to read data from rom file %s\n", filename);
-    return 2;
-  }
-  fclose(rom_file);
-
-  result = cartridge_init(nes, &cartridge, rom_data, rom_size);
+  free(cartridge_ram);
+  ram_size = cartridge_ram_size(rom->pchData, rom->wSize);
+  cartridge_ram = malloc(ram_size);
+  result = cartridge_init(nes, &cartridge, rom->pchData, rom->wSize, cartridge_ram, ram_size);
   nes_init(nes);
   if (result) {
     printf("unable to parse rom file (result:%d)\n", result);
@@ -98,14 +89,16 @@ int load_rom(nes_t *nes, char *filename) {
 }
 
 void free_rom() {
-  if (rom_data) {
-    free(rom_data);
-    rom_data=0;
-  }
+  free(cartridge_ram);
+  cartridge_ram=NULL;
+  rom_close(rom);
+  rom=NULL;
+  rom_cache_clear();
 }
 
 int main(int argc, char* argv[]) {
   test_mode_t test_mode;
+  ppu_backend_t ppu_backend=PPU_BACKEND_FRAMEBUFFER;
   ppu_t ppu;
   controller_direct_t controller;
   nes_t nes_console;
@@ -118,7 +111,12 @@ int main(int argc, char* argv[]) {
 
   // parse command line arguments
   if (argc<3) {
-    printf("%s [-r|-p|-a] [keypress file]\n", argv[0]);
+    printf("%s [-r|-p|-a] [keypress file] [framebuffer|caching]\n", argv[0]);
+    return 1;
+  }
+
+  if (argc>3 && !ppu_backend_from_name(argv[3], &ppu_backend)) {
+    printf("unknown ppu backend %s\n", argv[3]);
     return 1;
   }
 
@@ -155,7 +153,7 @@ int main(int argc, char* argv[]) {
     sdl_palette[idx]=SDL_MapRGB(screen->format, rgb_palette[idx].red, rgb_palette[idx].green, rgb_palette[idx].blue);
   }
 
-  ppu_init(&nes_console, &ppu, nes_frame_data);
+  ppu_init(&nes_console, &ppu, ppu_backend, nes_frame_data);
   controller_direct_init(&nes_console, &controller);
   
   int quit = 0;
@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ppu.h"
+#include "controller_direct.h"
+#include "cartridge.h"
+#include "rom.h"
+#include "nes.h"
+
+// plays a keypress file (see test_roms.c) without display and compares the screenshots
+
+static const uint8_t b64_table[64] = {
+  'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X',
+  'Y', 'Z', 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v',
+  'w', 'x', 'y', 'z', '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '+', '/'
+};
+
+const rom_t *rom=NULL;
+uint8_t *cartridge_ram=NULL;
+cartridge_t cartridge;
+
+int load_rom(nes_t *nes, char *filename) {
+  uint32_t ram_size;
+  int result;
+
+  rom_close(rom); // stays cached, e.g. for the next test of the same rom
+  rom=NULL;
+  if (rom_open(&rom, filename)!=rom_ok) {
+    printf("not able to open rom file %s\n", filename);
+    return 1;
+  }
+
+  free(cartridge_ram);
+  ram_size = cartridge_ram_size(rom->pchData, rom->wSize);
+  cartridge_ram = malloc(ram_size);
+  result = cartridge_init(nes, &cartridge, rom->pchData, rom->wSize, cartridge_ram, ram_size);
+  nes_init(nes);
+  if (result) {
+    printf("unable to parse rom file (result:%d)\n", result);
+    return 3;
+  }
+
+  return 0;
+}
+
+int main(int argc, char* argv[]) {
+  ppu_backend_t ppu_backend;
+  ppu_t ppu;
+  controller_direct_t controller;
+  nes_t nes_console;
+  FILE *keypress_file;
+  static uint8_t nes_frame_data[256*240];
+  static char line[256*240+3];
+  char *rom_name="";
+  unsigned int key_value=0;
+  int failed=0, checked=0, mismatches;
+  const char *name=argv[1];
+
+  if (argc<3) {
+    printf("%s [framebuffer|caching] [keypress file]\n", argv[0]);
+    return 1;
+  }
+
+  if (!ppu_backend_from_name(argv[1], &ppu_backend)) {
+    printf("unknown ppu backend %s\n", argv[1]);
+    return 1;
+  }
+
+  keypress_file=fopen(argv[2], "r");
+  if (keypress_file==NULL) {
+    printf("not able to open keypress file %s\n", argv[2]);
+    return 1;
+  }
+
+  ppu_init(&nes_console, &ppu, ppu_backend, nes_frame_data);
+  controller_direct_init(&nes_console, &controller);
+
+  while (fgets(line, sizeof(line), keypress_file)) {
+    line[strcspn(line, "\r\n")]=0;
+
+    switch (line[0]) {
+      case 'K': // simulate key press and advance one frame
+        sscanf(line+1, "%x", &key_value);
+        controller_direct_set(&nes_console, key_value, 0);
+        nes_iterate_frame(&nes_console);
+        break;
+      case 'S': // check screenshot
+        mismatches=0;
+        for (int p=0; p<256*240; p++) {
+          if (b64_table[nes_frame_data[p]&0x3F]!=(uint8_t)line[1+p]) {
+            mismatches++;
+          }
+        }
+        checked++;
+        if (mismatches) {
+          printf("[%s] %s: screenshot differs in %d pixels\n", name, rom_name, mismatches);
+          failed++;
+        }
+        break;
+      case 'L': // load rom
+        free(rom_name[0]?rom_name:NULL);
+        rom_name=strdup(line+1);
+        if (load_rom(&nes_console, line+1)) {
+          failed++;
+        }
+        break;
+      case 'R': // reset
+        nes_reset(&nes_console);
+        break;
+    }
+    if (line[0]=='Q') {
+      break;
+    }
+  }
+
+  printf("[%s] %d of %d screenshots matching\n", name, checked-failed, checked);
+
+  free(cartridge_ram);
+  rom_close(rom);
+  rom_cache_clear();
+  fclose(keypress_file);
+
+  return failed?1:0;
+}